@@ -1,10 +1,60 @@
 #include "engine.h"
 #include <engine.h>
 
-int main()
+static EngineSettings parseArgs(int argc, char** argv)
+{
+    EngineSettings settings{};
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc)
+                throw std::invalid_argument("missing value for " + arg);
+            return argv[++i];
+        };
+
+        if (arg == "--headless") {
+            settings.headless = true;
+        } else if (arg == "--frames") {
+            settings.benchmarkFrames = static_cast<uint32_t>(std::stoul(next()));
+        } else if (arg == "--camera-path") {
+            std::string path = next();
+            if (path == "static") {
+                settings.cameraPath = CameraPath::Static;
+            } else if (path == "orbit") {
+                settings.cameraPath = CameraPath::Orbit;
+            } else {
+                throw std::invalid_argument("unknown camera path: " + path);
+            }
+        } else if (arg == "--cpu-draws") {
+            settings.gpuCulling = false;
+        } else if (arg == "--float-vertices") {
+            settings.quantizeVertices = false;
+        } else if (arg == "--lod-threshold") {
+            settings.lodThreshold = std::stof(next());
+        } else if (arg == "--texture-budget") {
+            settings.textureBudgetMiB = static_cast<uint32_t>(std::stoul(next()));
+        } else if (arg == "--copies") {
+            settings.modelCopies = static_cast<uint32_t>(std::stoul(next()));
+        } else if (arg == "--bodies") {
+            settings.physicsBodies = static_cast<uint32_t>(std::stoul(next()));
+        } else if (arg == "--sim-thread") {
+            settings.threadedSimulation = true;
+        } else if (arg == "--report") {
+            settings.reportPath = next();
+        } else {
+            throw std::invalid_argument("unknown argument: " + arg);
+        }
+    }
+
+    if (settings.headless && settings.benchmarkFrames == 0)
+        settings.benchmarkFrames = 300;
+    return settings;
+}
+
+int main(int argc, char** argv)
 {
     try {
-        GNVEngine app;
+        GNVEngine app{ parseArgs(argc, argv) };
         app.run();
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
@@ -0,0 +1,84 @@
+#include <bindless_table.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+BindlessTable::BindlessTable(const vk::raii::Device& device, uint32_t binding, uint32_t capacity,
+                             uint32_t framesInFlight)
+    : device(&device), binding(binding), capacity(capacity), framesInFlight(framesInFlight),
+      pendingWrites(framesInFlight)
+{
+}
+
+uint32_t BindlessTable::getDeviceCapacity(const vk::raii::PhysicalDevice& physicalDevice, uint32_t limit)
+{
+    auto properties = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2,
+                                                    vk::PhysicalDeviceDescriptorIndexingProperties>();
+    const auto& indexing = properties.get<vk::PhysicalDeviceDescriptorIndexingProperties>();
+    // A combined image sampler counts as both a sampled image and a sampler
+    return std::min({ limit, indexing.maxDescriptorSetUpdateAfterBindSampledImages,
+                      indexing.maxDescriptorSetUpdateAfterBindSamplers,
+                      indexing.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                      indexing.maxPerStageDescriptorUpdateAfterBindSamplers,
+                      indexing.maxPerStageUpdateAfterBindResources });
+}
+
+uint32_t BindlessTable::allocate()
+{
+    uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else if (nextSlot < capacity) {
+        slot = nextSlot++;
+    } else {
+        throw std::runtime_error("bindless texture table is full!");
+    }
+    usedCount++;
+    return slot;
+}
+
+void BindlessTable::free(uint32_t slot)
+{
+    // Partially bound, so the stale descriptor is fine as long as nothing indexes it
+    pendingFrees.push_back(PendingFree{ slot, frameCounter });
+    usedCount--;
+}
+
+void BindlessTable::set(uint32_t slot, vk::ImageView imageView, vk::Sampler sampler)
+{
+    vk::DescriptorImageInfo info{};
+    info.setSampler(sampler).setImageView(imageView).setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+    for (auto& writes : pendingWrites)
+        writes.push_back(PendingWrite{ slot, info });
+}
+
+void BindlessTable::flush(uint32_t frame, vk::DescriptorSet descriptorSet)
+{
+    frameCounter++;
+    std::erase_if(pendingFrees, [&](const PendingFree& pending) {
+        if (frameCounter - pending.frame < framesInFlight)
+            return false;
+        freeSlots.push_back(pending.slot);
+        return true;
+    });
+
+    auto& writes = pendingWrites[frame];
+    if (writes.empty())
+        return;
+    // Later writes to the same slot land after earlier ones, so the last set() wins
+    std::vector<vk::WriteDescriptorSet> descriptorWrites;
+    descriptorWrites.reserve(writes.size());
+    for (const auto& write : writes) {
+        vk::WriteDescriptorSet descriptorWrite{};
+        descriptorWrite.setDstSet(descriptorSet)
+            .setDstBinding(binding)
+            .setDstArrayElement(write.slot)
+            .setDescriptorCount(1)
+            .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+            .setPImageInfo(&write.info);
+        descriptorWrites.push_back(descriptorWrite);
+    }
+    device->updateDescriptorSets(descriptorWrites, {});
+    writes.clear();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Vulkan
+#include <vulkan/vulkan_raii.hpp>
+
+// Hands out the slots of a bindless combined image sampler array that every frame in flight has its own descriptor
+// set for. The array is sized once from the device limits, so the sets never have to be allocated again as textures
+// come and go. Changes to a slot are queued for every frame and written into a frame's set in one update when that
+// frame comes around; freed slots are held back until the frames that may still sample them have finished.
+class BindlessTable
+{
+  public:
+    BindlessTable(std::nullptr_t) {}
+    BindlessTable(const vk::raii::Device& device, uint32_t binding, uint32_t capacity, uint32_t framesInFlight);
+
+    // The largest array the device allows in an update-after-bind set, but no more than limit
+    static uint32_t getDeviceCapacity(const vk::raii::PhysicalDevice& physicalDevice, uint32_t limit);
+
+    // Throws when every slot is taken
+    uint32_t allocate();
+    void free(uint32_t slot);
+    // Points slot at imageView and sampler, imageView in SHADER_READ_ONLY_OPTIMAL
+    void set(uint32_t slot, vk::ImageView imageView, vk::Sampler sampler);
+    // Call once per frame after waiting for its fence, with the descriptor set of that frame. Writes the changes the
+    // set hasn't seen yet and releases frees that are now safe to reuse.
+    void flush(uint32_t frame, vk::DescriptorSet descriptorSet);
+
+    [[nodiscard]] uint32_t getCapacity() const { return capacity; }
+    [[nodiscard]] uint32_t getUsedCount() const { return usedCount; }
+
+  private:
+    struct PendingFree {
+        uint32_t slot;
+        uint64_t frame;
+    };
+
+    struct PendingWrite {
+        uint32_t slot;
+        vk::DescriptorImageInfo info;
+    };
+
+    const vk::raii::Device* device = nullptr;
+    uint32_t binding = 0;
+    uint32_t capacity = 0;
+    uint32_t framesInFlight = 0;
+    uint64_t frameCounter = 0;
+    // Slots at or above this have never been handed out
+    uint32_t nextSlot = 0;
+    uint32_t usedCount = 0;
+
+    std::vector<uint32_t> freeSlots;
+    std::vector<PendingFree> pendingFrees;
+    // Indexed by frame in flight
+    std::vector<std::vector<PendingWrite>> pendingWrites;
+};
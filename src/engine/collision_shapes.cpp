@@ -0,0 +1,209 @@
+#include <collision_shapes.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include <Jolt/Core/StreamWrapper.h>
+#include <Jolt/Geometry/IndexedTriangle.h>
+#include <Jolt/Physics/Collision/Shape/BoxShape.h>
+#include <Jolt/Physics/Collision/Shape/ConvexHullShape.h>
+#include <Jolt/Physics/Collision/Shape/MeshShape.h>
+#include <Jolt/Physics/Collision/Shape/RotatedTranslatedShape.h>
+#include <Jolt/Physics/Collision/Shape/ScaledShape.h>
+#include <Jolt/Physics/Collision/Shape/StaticCompoundShape.h>
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/matrix_decompose.hpp>
+
+namespace
+{
+constexpr std::array<char, 4> COLLISION_SHAPE_MAGIC = { 'G', 'N', 'V', 'C' };
+// Jolt's binary shape format isn't versioned, a shape is only read back by the Jolt it was written by
+constexpr uint32_t JOLT_VERSION = (JPH_VERSION_MAJOR << 16) | (JPH_VERSION_MINOR << 8) | JPH_VERSION_PATCH;
+// Thinner than this and a degenerate mesh's bounding box still gets some thickness
+constexpr float MIN_BOX_HALF_EXTENT = 1e-3f;
+
+struct FileHeader {
+    std::array<char, 4> magic;
+    uint32_t version;
+    uint32_t joltVersion;
+    uint32_t realSize;
+    uint64_t key;
+};
+
+// FNV-1a, the cache only needs it to tell meshes apart
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+{
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+JPH::Vec3 toJolt(const glm::vec3& v)
+{
+    return JPH::Vec3(v.x, v.y, v.z);
+}
+
+JPH::ShapeRefC createShape(const JPH::ShapeSettings& settings)
+{
+    JPH::ShapeSettings::ShapeResult result = settings.Create();
+    if (result.HasError())
+        throw std::runtime_error("failed to create collision shape: " + std::string(result.GetError().c_str()));
+    return result.Get();
+}
+
+JPH::ShapeRefC cookMeshShape(const CollisionGeometry& geometry)
+{
+    JPH::VertexList vertices;
+    vertices.reserve(geometry.positions.size());
+    for (const glm::vec3& position : geometry.positions)
+        vertices.push_back(JPH::Float3(position.x, position.y, position.z));
+    JPH::IndexedTriangleList triangles;
+    triangles.reserve(geometry.indices.size() / 3);
+    for (size_t i = 0; i + 2 < geometry.indices.size(); i += 3)
+        triangles.emplace_back(geometry.indices[i], geometry.indices[i + 1], geometry.indices[i + 2]);
+
+    // The settings drop degenerate triangles, which may be all of them
+    JPH::MeshShapeSettings settings(std::move(vertices), std::move(triangles));
+    if (settings.mIndexedTriangles.empty())
+        return nullptr;
+    return createShape(settings);
+}
+
+JPH::ShapeRefC cookConvexHull(const CollisionGeometry& geometry)
+{
+    // Only vertices the triangles use count, coarser LODs share the vertex data but may not use all of it
+    std::vector<uint8_t> used(geometry.positions.size(), 0);
+    for (uint32_t index : geometry.indices)
+        used[index] = 1;
+    JPH::Array<JPH::Vec3> points;
+    glm::vec3 min{ std::numeric_limits<float>::max() };
+    glm::vec3 max{ std::numeric_limits<float>::lowest() };
+    for (size_t i = 0; i < geometry.positions.size(); ++i) {
+        if (!used[i])
+            continue;
+        points.push_back(toJolt(geometry.positions[i]));
+        min = glm::min(min, geometry.positions[i]);
+        max = glm::max(max, geometry.positions[i]);
+    }
+
+    JPH::ConvexHullShapeSettings settings(points);
+    JPH::ShapeSettings::ShapeResult result = settings.Create();
+    if (!result.HasError())
+        return result.Get();
+    // The hull builder gives up on flat point sets, a thin box around them collides the same
+    glm::vec3 halfExtent = glm::max((max - min) * 0.5f, glm::vec3(MIN_BOX_HALF_EXTENT));
+    JPH::RotatedTranslatedShapeSettings box(toJolt((min + max) * 0.5f), JPH::Quat::sIdentity(),
+                                            createBoxShape(halfExtent));
+    return createShape(box);
+}
+} // namespace
+
+uint64_t hashCollisionGeometry(const CollisionGeometry& geometry, CollisionShapeKind kind)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    hash = hashBytes(hash, &COLLISION_SHAPE_VERSION, sizeof(COLLISION_SHAPE_VERSION));
+    hash = hashBytes(hash, &kind, sizeof(kind));
+    uint64_t counts[2] = { geometry.positions.size(), geometry.indices.size() };
+    hash = hashBytes(hash, counts, sizeof(counts));
+    hash = hashBytes(hash, geometry.positions.data(), geometry.positions.size() * sizeof(glm::vec3));
+    return hashBytes(hash, geometry.indices.data(), geometry.indices.size() * sizeof(uint32_t));
+}
+
+JPH::ShapeRefC cookCollisionShape(const CollisionGeometry& geometry, CollisionShapeKind kind)
+{
+    if (geometry.indices.size() < 3)
+        return nullptr;
+    for (uint32_t index : geometry.indices) {
+        if (index >= geometry.positions.size())
+            throw std::runtime_error("collision geometry index out of range!");
+    }
+    return kind == CollisionShapeKind::Mesh ? cookMeshShape(geometry) : cookConvexHull(geometry);
+}
+
+JPH::ShapeRefC createBoxShape(const glm::vec3& halfExtent)
+{
+    float radius = std::min(JPH::cDefaultConvexRadius, 0.5f * std::min({ halfExtent.x, halfExtent.y, halfExtent.z }));
+    return new JPH::BoxShape(toJolt(halfExtent), radius);
+}
+
+JPH::ShapeRefC createCompoundShape(std::span<const CollisionPart> parts)
+{
+    JPH::StaticCompoundShapeSettings settings;
+    for (const CollisionPart& part : parts) {
+        if (part.shape == nullptr)
+            continue;
+        glm::vec3 scale, translation, skew;
+        glm::quat rotation;
+        glm::vec4 perspective;
+        if (!glm::decompose(part.transform, scale, rotation, translation, skew, perspective))
+            continue;
+        JPH::ShapeRefC shape = part.shape;
+        if (glm::any(glm::greaterThan(glm::abs(scale - glm::vec3(1.0f)), glm::vec3(1e-4f))))
+            shape = new JPH::ScaledShape(shape, toJolt(scale));
+        JPH::Quat joltRotation(rotation.x, rotation.y, rotation.z, rotation.w);
+        settings.AddShape(toJolt(translation), joltRotation.Normalized(), shape);
+    }
+    if (settings.mSubShapes.empty())
+        return nullptr;
+    return createShape(settings);
+}
+
+JPH::ShapeRefC CollisionShapeCache::load(uint64_t key) const
+{
+    std::ifstream file(getPath(key), std::ios::binary);
+    if (!file.is_open())
+        return nullptr;
+    FileHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != COLLISION_SHAPE_MAGIC || header.version != COLLISION_SHAPE_VERSION ||
+        header.joltVersion != JOLT_VERSION || header.realSize != sizeof(JPH::Real) || header.key != key) {
+        return nullptr;
+    }
+
+    JPH::StreamInWrapper stream(file);
+    JPH::Shape::IDToShapeMap shapes;
+    JPH::Shape::IDToMaterialMap materials;
+    JPH::Shape::ShapeResult result = JPH::Shape::sRestoreWithChildren(stream, shapes, materials);
+    if (stream.IsFailed() || result.HasError())
+        return nullptr;
+    return result.Get();
+}
+
+void CollisionShapeCache::save(uint64_t key, const JPH::Shape& shape) const
+{
+    std::filesystem::path path = getPath(key);
+    std::filesystem::create_directories(path.parent_path());
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            throw std::runtime_error("failed to open " + tempPath.string());
+        FileHeader header{ COLLISION_SHAPE_MAGIC, COLLISION_SHAPE_VERSION, JOLT_VERSION, sizeof(JPH::Real), key };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        JPH::StreamOutWrapper stream(file);
+        JPH::Shape::ShapeToIDMap shapes;
+        JPH::Shape::MaterialToIDMap materials;
+        shape.SaveWithChildren(stream, shapes, materials);
+        if (!file || stream.IsFailed())
+            throw std::runtime_error("failed to write " + tempPath.string());
+    }
+    std::filesystem::rename(tempPath, path);
+}
+
+std::filesystem::path CollisionShapeCache::getPath(uint64_t key) const
+{
+    return directory / std::format("{:016x}.jshape", key);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+// JoltPhysics, Jolt.h goes first
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Collision/Shape/Shape.h>
+
+// Expects the engine's GLM configuration, include through engine.h
+#include <glm/glm.hpp>
+
+// Bump whenever cooking changes what a shape is built from or how, cached shapes from other versions get re-cooked
+constexpr uint32_t COLLISION_SHAPE_VERSION = 1;
+
+enum class CollisionShapeKind : uint32_t {
+    // Exact triangles, for static bodies only
+    Mesh,
+    // The convex hull of the vertices, what a dynamic body can use. Flat or degenerate meshes get their bounding box.
+    ConvexHull,
+};
+
+// A render mesh's triangles in its object space, decoded from whatever vertex and index format it was cooked to
+struct CollisionGeometry {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+};
+
+// A shape and where it sits, for createCompoundShape()
+struct CollisionPart {
+    JPH::ShapeRefC shape;
+    glm::mat4 transform{ 1.0f };
+};
+
+// The collision shapes of one render mesh, either is null if the mesh has no triangles
+struct MeshCollision {
+    JPH::ShapeRefC mesh;
+    JPH::ShapeRefC hull;
+};
+
+// What identifies a shape in the cache: the geometry's content, the kind and the cooking version
+[[nodiscard]] uint64_t hashCollisionGeometry(const CollisionGeometry& geometry, CollisionShapeKind kind);
+// Slow for large meshes, which is what CollisionShapeCache is for. Returns null when there are no triangles to build
+// from, throws if Jolt fails on the ones there are.
+[[nodiscard]] JPH::ShapeRefC cookCollisionShape(const CollisionGeometry& geometry, CollisionShapeKind kind);
+// A box thinner than Jolt's default convex radius gets a smaller one
+[[nodiscard]] JPH::ShapeRefC createBoxShape(const glm::vec3& halfExtent);
+// One static compound of every part, scaled parts are wrapped in a ScaledShape. Returns null if there are no parts.
+[[nodiscard]] JPH::ShapeRefC createCompoundShape(std::span<const CollisionPart> parts);
+
+// Cooked shapes on disk, one file per shape named by its hash and saved in Jolt's binary shape format. Files written
+// by another COLLISION_SHAPE_VERSION or Jolt version are treated as missing. Loads and saves of different keys may
+// run on different threads at once.
+class CollisionShapeCache
+{
+  public:
+    explicit CollisionShapeCache(std::filesystem::path directory) : directory(std::move(directory)) {}
+
+    // Returns null when the shape isn't cached, or its file is stale or malformed. Needs Jolt's types registered.
+    [[nodiscard]] JPH::ShapeRefC load(uint64_t key) const;
+    // Writes to a temporary file and renames it over the old one, so a crash never leaves a torn file behind
+    void save(uint64_t key, const JPH::Shape& shape) const;
+
+  private:
+    std::filesystem::path directory;
+
+    [[nodiscard]] std::filesystem::path getPath(uint64_t key) const;
+};
@@ -0,0 +1,211 @@
+#include <cooked_model.h>
+
+#include <cstring>
+#include <fstream>
+#include <spanstream>
+#include <sstream>
+#include <stdexcept>
+
+// cereal
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/array.hpp>
+#include <cereal/types/vector.hpp>
+
+namespace
+{
+constexpr std::array<char, 4> COOKED_MODEL_MAGIC = { 'G', 'N', 'V', 'M' };
+// Blobs start on this boundary so mapped vertex and index data can be viewed in place
+constexpr uint64_t COOKED_DATA_ALIGNMENT = 16;
+
+// Read with memcpy before anything else, so a version bump can change the table of contents freely
+struct FileHeader {
+    std::array<char, 4> magic;
+    uint32_t version;
+    uint32_t tocSize;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+};
+
+uint64_t alignUp(uint64_t value)
+{
+    return (value + COOKED_DATA_ALIGNMENT - 1) / COOKED_DATA_ALIGNMENT * COOKED_DATA_ALIGNMENT;
+}
+} // namespace
+
+CookedModelSource CookedModelSource::of(const std::filesystem::path& path)
+{
+    CookedModelSource source{};
+    source.size = std::filesystem::file_size(path);
+    source.writeTime = std::filesystem::last_write_time(path).time_since_epoch().count();
+    return source;
+}
+
+uint32_t CookedModelWriter::addImage(std::span<const std::byte> ktx2)
+{
+    images.push_back(CookedImage{ append(ktx2), ktx2.size() });
+    return static_cast<uint32_t>(images.size() - 1);
+}
+
+uint32_t CookedModelWriter::addMaterial(const CookedMaterial& material)
+{
+    materials.push_back(material);
+    return static_cast<uint32_t>(materials.size() - 1);
+}
+
+void CookedModelWriter::addMesh(CookedMesh mesh, std::span<const std::byte> vertices,
+                                std::span<const std::byte> indices, std::span<const CookedMeshlet> meshlets)
+{
+    if (mesh.vertexStride == 0 || vertices.size() % mesh.vertexStride != 0)
+        throw std::runtime_error("vertex data is not a whole number of vertices!");
+    if ((mesh.indexStride != sizeof(uint16_t) && mesh.indexStride != sizeof(uint32_t)) ||
+        indices.size() % mesh.indexStride != 0) {
+        throw std::runtime_error("index data is not a whole number of 16- or 32-bit indices!");
+    }
+    mesh.vertexOffset = append(vertices);
+    mesh.vertexCount = vertices.size() / mesh.vertexStride;
+    mesh.indexOffset = append(indices);
+    mesh.indexCount = indices.size() / mesh.indexStride;
+    mesh.meshletOffset = append(std::as_bytes(meshlets));
+    mesh.meshletCount = meshlets.size();
+    if (mesh.lods.empty())
+        mesh.lods.push_back(CookedLod{ 0, mesh.indexCount, 0.0f });
+    meshes.push_back(mesh);
+}
+
+uint32_t CookedModelWriter::addNode(const CookedNode& node)
+{
+    if (node.parent >= static_cast<int32_t>(nodes.size()))
+        throw std::runtime_error("node added before its parent!");
+    nodes.push_back(node);
+    return static_cast<uint32_t>(nodes.size() - 1);
+}
+
+std::vector<std::byte> CookedModelWriter::finish(const CookedModelSource& source) const
+{
+    std::ostringstream toc;
+    {
+        cereal::BinaryOutputArchive archive(toc);
+        archive(source, meshes, materials, images, nodes);
+    }
+    std::string tocBytes = toc.str();
+
+    FileHeader header{};
+    header.magic = COOKED_MODEL_MAGIC;
+    header.version = COOKED_MODEL_VERSION;
+    header.tocSize = static_cast<uint32_t>(tocBytes.size());
+    header.dataOffset = alignUp(sizeof(FileHeader) + tocBytes.size());
+    header.dataSize = data.size();
+
+    std::vector<std::byte> bytes(header.dataOffset + data.size());
+    memcpy(bytes.data(), &header, sizeof(FileHeader));
+    memcpy(bytes.data() + sizeof(FileHeader), tocBytes.data(), tocBytes.size());
+    memcpy(bytes.data() + header.dataOffset, data.data(), data.size());
+    return bytes;
+}
+
+uint64_t CookedModelWriter::append(std::span<const std::byte> bytes)
+{
+    uint64_t offset = alignUp(data.size());
+    data.resize(offset + bytes.size());
+    memcpy(data.data() + offset, bytes.data(), bytes.size());
+    return offset;
+}
+
+CookedModel::CookedModel(std::vector<std::byte> bytes) : storage(std::move(bytes))
+{
+    if (!parse(storage))
+        throw std::runtime_error("malformed cooked model!");
+}
+
+std::optional<CookedModel> CookedModel::open(const std::filesystem::path& path, const CookedModelSource& source)
+{
+    if (!std::filesystem::exists(path))
+        return std::nullopt;
+
+    CookedModel model = nullptr;
+    try {
+        model.file = MappedFile(path);
+    } catch (const std::runtime_error&) {
+        return std::nullopt;
+    }
+    if (!model.parse(model.file.getData()) || model.source != source)
+        return std::nullopt;
+    return model;
+}
+
+void CookedModel::save(const std::filesystem::path& path, std::span<const std::byte> bytes)
+{
+    std::filesystem::create_directories(path.parent_path());
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            throw std::runtime_error("failed to open " + tempPath.string());
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!file)
+            throw std::runtime_error("failed to write " + tempPath.string());
+    }
+    std::filesystem::rename(tempPath, path);
+}
+
+bool CookedModel::parse(std::span<const std::byte> bytes)
+{
+    FileHeader header{};
+    if (bytes.size() < sizeof(FileHeader))
+        return false;
+    memcpy(&header, bytes.data(), sizeof(FileHeader));
+    if (header.magic != COOKED_MODEL_MAGIC || header.version != COOKED_MODEL_VERSION ||
+        sizeof(FileHeader) + header.tocSize > bytes.size() || header.dataOffset % COOKED_DATA_ALIGNMENT != 0 ||
+        header.dataOffset > bytes.size() || header.dataSize > bytes.size() - header.dataOffset) {
+        return false;
+    }
+
+    try {
+        auto toc = bytes.subspan(sizeof(FileHeader), header.tocSize);
+        std::ispanstream stream(std::span<const char>(reinterpret_cast<const char*>(toc.data()), toc.size()));
+        cereal::BinaryInputArchive archive(stream);
+        archive(source, meshes, materials, images, nodes);
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    // Everything the views hand out has to lie inside the data section
+    auto inside = [&](uint64_t offset, uint64_t count, uint64_t stride) {
+        return offset % COOKED_DATA_ALIGNMENT == 0 && offset <= header.dataSize &&
+               count <= (header.dataSize - offset) / stride;
+    };
+    for (const auto& mesh : meshes) {
+        if (mesh.vertexStride == 0 || !inside(mesh.vertexOffset, mesh.vertexCount, mesh.vertexStride) ||
+            (mesh.indexStride != sizeof(uint16_t) && mesh.indexStride != sizeof(uint32_t)) ||
+            !inside(mesh.indexOffset, mesh.indexCount, mesh.indexStride) ||
+            !inside(mesh.meshletOffset, mesh.meshletCount, sizeof(CookedMeshlet)) ||
+            mesh.material >= static_cast<int32_t>(materials.size()) || mesh.lods.empty()) {
+            return false;
+        }
+        for (const auto& lod : mesh.lods) {
+            if (lod.firstIndex > mesh.indexCount || lod.indexCount > mesh.indexCount - lod.firstIndex ||
+                lod.firstMeshlet > mesh.meshletCount || lod.meshletCount > mesh.meshletCount - lod.firstMeshlet) {
+                return false;
+            }
+        }
+    }
+    for (const auto& material : materials) {
+        if (material.baseColorImage >= static_cast<int32_t>(images.size()))
+            return false;
+    }
+    for (const auto& image : images) {
+        if (!inside(image.offset, image.size, 1))
+            return false;
+    }
+    for (size_t n = 0; n < nodes.size(); ++n) {
+        const auto& node = nodes[n];
+        if (node.parent >= static_cast<int64_t>(n) || node.firstMesh > meshes.size() ||
+            node.meshCount > meshes.size() - node.firstMesh) {
+            return false;
+        }
+    }
+
+    dataSection = bytes.subspan(header.dataOffset, header.dataSize);
+    return true;
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <mapped_file.h>
+
+// Bump whenever anything below changes how a cooked model is laid out, or the cooking steps change what goes into
+// it; files from other versions get re-cooked
+constexpr uint32_t COOKED_MODEL_VERSION = 8;
+
+// Identifies the file a model was cooked from. A cooked model is stale once its source no longer matches.
+struct CookedModelSource {
+    uint64_t size = 0;
+    int64_t writeTime = 0;
+
+    static CookedModelSource of(const std::filesystem::path& path);
+    bool operator==(const CookedModelSource&) const = default;
+
+    template <class Archive> void serialize(Archive& archive) { archive(size, writeTime); }
+};
+
+// A small cluster of neighbouring triangles, stored as is in the data section. Its triangles are a run of the mesh's
+// indices; the bounding sphere and backface cone are in the mesh's object space.
+struct CookedMeshlet {
+    uint32_t firstIndex;
+    uint32_t triangleCount;
+    std::array<float, 3> center;
+    float radius;
+    std::array<float, 3> coneApex;
+    std::array<float, 3> coneAxis;
+    float coneCutoff;
+};
+static_assert(sizeof(CookedMeshlet) == 52);
+
+// A level of detail: a run of the mesh's indices, and how far in object space it may be off from level 0. Its
+// indices are in meshlet order, and its meshlets a run of the mesh's.
+struct CookedLod {
+    uint64_t firstIndex = 0;
+    uint64_t indexCount = 0;
+    float error = 0.0f;
+    uint64_t firstMeshlet = 0;
+    uint64_t meshletCount = 0;
+
+    template <class Archive> void serialize(Archive& archive)
+    {
+        archive(firstIndex, indexCount, error, firstMeshlet, meshletCount);
+    }
+};
+
+// Offsets are in bytes from the start of the data section. Indices are already rebased onto the mesh's vertices and
+// are 16 or 32 bits wide (indexStride).
+// vertexFormat is opaque to the cooked model; quantized formats are decoded as offset + stored * scale. Every LOD
+// indexes the same vertices, level 0 being the full resolution mesh.
+struct CookedMesh {
+    uint64_t vertexOffset = 0;
+    uint64_t vertexCount = 0;
+    uint64_t indexOffset = 0;
+    uint64_t indexCount = 0;
+    uint64_t meshletOffset = 0;
+    uint64_t meshletCount = 0;
+    uint32_t vertexFormat = 0;
+    uint32_t vertexStride = 0;
+    uint32_t indexStride = sizeof(uint32_t);
+    int32_t material = -1;
+    std::array<float, 3> boundsMin{};
+    std::array<float, 3> boundsMax{};
+    std::array<float, 3> positionOffset{};
+    std::array<float, 3> positionScale{ 1.0f, 1.0f, 1.0f };
+    std::array<float, 2> uvOffset{};
+    std::array<float, 2> uvScale{ 1.0f, 1.0f };
+    std::vector<CookedLod> lods;
+
+    template <class Archive> void serialize(Archive& archive)
+    {
+        archive(vertexOffset, vertexCount, indexOffset, indexCount, meshletOffset, meshletCount, vertexFormat,
+                vertexStride, indexStride, material, boundsMin, boundsMax, positionOffset, positionScale, uvOffset,
+                uvScale, lods);
+    }
+};
+
+struct CookedMaterial {
+    int32_t baseColorImage = -1;
+    // Back faces are drawn and never culled
+    bool doubleSided = false;
+
+    template <class Archive> void serialize(Archive& archive) { archive(baseColorImage, doubleSided); }
+};
+
+// A node of the model's scene, stored parents first. It draws the cooked meshes [firstMesh, firstMesh + meshCount),
+// which are the windows of one glTF mesh.
+struct CookedNode {
+    int32_t parent = -1;
+    uint32_t firstMesh = 0;
+    uint32_t meshCount = 0;
+    // Column-major, relative to the parent
+    std::array<float, 16> matrix{ 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+                                  0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+
+    template <class Archive> void serialize(Archive& archive) { archive(parent, firstMesh, meshCount, matrix); }
+};
+
+// An embedded KTX2 file, transcoded at load time
+struct CookedImage {
+    uint64_t offset = 0;
+    uint64_t size = 0;
+
+    template <class Archive> void serialize(Archive& archive) { archive(offset, size); }
+};
+
+// Collects a model's GPU-ready vertex/index data, materials, images and nodes and lays them out as a cooked model
+class CookedModelWriter
+{
+  public:
+    uint32_t addImage(std::span<const std::byte> ktx2);
+    uint32_t addMaterial(const CookedMaterial& material);
+    // Fills in mesh's offsets and counts, and a single LOD over all indices if it has none. Everything else is stored
+    // as given.
+    void addMesh(CookedMesh mesh, std::span<const std::byte> vertices, std::span<const std::byte> indices,
+                 std::span<const CookedMeshlet> meshlets);
+    // Nodes have to come after their parent
+    uint32_t addNode(const CookedNode& node);
+
+    [[nodiscard]] std::vector<std::byte> finish(const CookedModelSource& source) const;
+
+  private:
+    std::vector<CookedMesh> meshes;
+    std::vector<CookedMaterial> materials;
+    std::vector<CookedImage> images;
+    std::vector<CookedNode> nodes;
+    std::vector<std::byte> data;
+
+    uint64_t append(std::span<const std::byte> bytes);
+};
+
+// A cooked model: a fixed header, a cereal table of contents and a data section of vertex, index and image blobs.
+// Loaded from disk it is memory-mapped and nothing is parsed beyond the table of contents, so meshes go straight
+// from the mapping into staging memory.
+class CookedModel
+{
+  public:
+    CookedModel(std::nullptr_t) {}
+    // Takes a freshly cooked model as is, throws if it's malformed
+    explicit CookedModel(std::vector<std::byte> bytes);
+
+    // Returns std::nullopt when the file is missing, malformed, from another version, or cooked from a different
+    // source
+    static std::optional<CookedModel> open(const std::filesystem::path& path, const CookedModelSource& source);
+    // Writes to a temporary file and renames it over path, so a crash never leaves a torn file behind
+    static void save(const std::filesystem::path& path, std::span<const std::byte> bytes);
+
+    [[nodiscard]] const std::vector<CookedMesh>& getMeshes() const { return meshes; }
+    [[nodiscard]] const std::vector<CookedMaterial>& getMaterials() const { return materials; }
+    [[nodiscard]] const std::vector<CookedImage>& getImages() const { return images; }
+    [[nodiscard]] const std::vector<CookedNode>& getNodes() const { return nodes; }
+    [[nodiscard]] bool isMapped() const { return !file.getData().empty(); }
+
+    template <typename T> [[nodiscard]] std::span<const T> view(uint64_t offset, uint64_t count) const
+    {
+        return { reinterpret_cast<const T*>(dataSection.data() + offset), static_cast<size_t>(count) };
+    }
+    [[nodiscard]] std::span<const std::byte> getImageData(const CookedImage& image) const
+    {
+        return dataSection.subspan(image.offset, image.size);
+    }
+
+  private:
+    MappedFile file = nullptr;
+    std::vector<std::byte> storage;
+    std::span<const std::byte> dataSection;
+    CookedModelSource source{};
+    std::vector<CookedMesh> meshes;
+    std::vector<CookedMaterial> materials;
+    std::vector<CookedImage> images;
+    std::vector<CookedNode> nodes;
+
+    bool parse(std::span<const std::byte> bytes);
+};
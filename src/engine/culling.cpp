@@ -0,0 +1,47 @@
+#include <engine.h>
+
+Frustum Frustum::fromMatrix(const glm::mat4& clip)
+{
+    // GLM is column-major, so row i is (clip[0][i], clip[1][i], clip[2][i], clip[3][i])
+    auto row = [&](int i) { return glm::vec4(clip[0][i], clip[1][i], clip[2][i], clip[3][i]); };
+
+    Frustum frustum{};
+    frustum.planes[0] = row(3) + row(0); // left
+    frustum.planes[1] = row(3) - row(0); // right
+    frustum.planes[2] = row(3) + row(1); // bottom
+    frustum.planes[3] = row(3) - row(1); // top
+    frustum.planes[4] = row(2);          // near, z >= 0
+    frustum.planes[5] = row(3) - row(2); // far
+    for (auto& plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+bool Frustum::intersects(const Aabb& box) const
+{
+    for (auto& plane : planes) {
+        // The corner furthest along the plane normal
+        glm::vec3 positive{ plane.x >= 0.0f ? box.max.x : box.min.x, plane.y >= 0.0f ? box.max.y : box.min.y,
+                            plane.z >= 0.0f ? box.max.z : box.min.z };
+        if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+Containment Frustum::classify(const Aabb& box) const
+{
+    Containment result = Containment::Inside;
+    for (auto& plane : planes) {
+        glm::vec3 normal{ plane };
+        glm::vec3 positive{ normal.x >= 0.0f ? box.max.x : box.min.x, normal.y >= 0.0f ? box.max.y : box.min.y,
+                            normal.z >= 0.0f ? box.max.z : box.min.z };
+        glm::vec3 negative{ normal.x >= 0.0f ? box.min.x : box.max.x, normal.y >= 0.0f ? box.min.y : box.max.y,
+                            normal.z >= 0.0f ? box.min.z : box.max.z };
+        if (glm::dot(normal, positive) + plane.w < 0.0f)
+            return Containment::Outside;
+        if (glm::dot(normal, negative) + plane.w < 0.0f)
+            result = Containment::Intersects;
+    }
+    return result;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <limits>
+
+// Expects the engine's GLM configuration, include through engine.h
+#include <glm/glm.hpp>
+
+struct Aabb {
+    glm::vec3 min{ std::numeric_limits<float>::max() };
+    glm::vec3 max{ std::numeric_limits<float>::lowest() };
+
+    void expand(const glm::vec3& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+    void expand(const Aabb& other)
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+    [[nodiscard]] bool valid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+};
+
+enum class Containment { Outside, Intersects, Inside };
+
+// Planes point inwards: xyz is the normal, w the distance, and a point p is inside when dot(xyz, p) + w >= 0
+struct Frustum {
+    std::array<glm::vec4, 6> planes;
+
+    // Extracts the planes of a clip matrix with [0, 1] depth, in the space the matrix maps from
+    static Frustum fromMatrix(const glm::mat4& clip);
+    [[nodiscard]] bool intersects(const Aabb& box) const;
+    [[nodiscard]] Containment classify(const Aabb& box) const;
+};
@@ -55,30 +55,53 @@ void GNVEngine::framebufferResizeCallback(GLFWwindow* window, int width, int hei
 
 void GNVEngine::initVulkan()
 {
+    auto startupStart = std::chrono::high_resolution_clock::now();
     EngineLog::logger->trace("createInstance()");
     createInstance();
     EngineLog::logger->trace("setupDebugMessenger()");
     setupDebugMessenger();
-    EngineLog::logger->trace("createSurface()");
-    createSurface();
+    if (!settings.headless) {
+        EngineLog::logger->trace("createSurface()");
+        createSurface();
+    }
     EngineLog::logger->trace("pickPhysicalDevice()");
     pickPhysicalDevice();
     EngineLog::logger->trace("createLogicalDevice()");
     createLogicalDevice();
-    EngineLog::logger->trace("createSwapChain()");
-    createSwapChain();
-    EngineLog::logger->trace("createImageViews()");
-    createImageViews();
+    EngineLog::logger->trace("chooseTranscodeTargets()");
+    chooseTranscodeTargets();
+    EngineLog::logger->trace("createAllocator()");
+    createAllocator();
+    EngineLog::logger->trace("createPipelineCache()");
+    createPipelineCache();
+    if (settings.headless) {
+        EngineLog::logger->trace("createOffscreenTargets()");
+        createOffscreenTargets();
+    } else {
+        EngineLog::logger->trace("createSwapChain()");
+        createSwapChain();
+        EngineLog::logger->trace("createImageViews()");
+        createImageViews();
+    }
+    EngineLog::logger->trace("createBindlessTable()");
+    createBindlessTable();
     EngineLog::logger->trace("createDescriptorSetLayout()");
     createDescriptorSetLayout();
+    auto pipelineStart = std::chrono::high_resolution_clock::now();
     EngineLog::logger->trace("createGraphicsPipeline()");
     createGraphicsPipeline();
+    EngineLog::logger->trace("createCullPipeline()");
+    createCullPipeline();
+    double pipelineMs =
+        std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - pipelineStart).count();
     EngineLog::logger->trace("createCommandPool()");
     createCommandPool();
+    EngineLog::logger->trace("createUploadScheduler()");
+    createUploadScheduler();
+    EngineLog::logger->trace("createGeometryArena()");
+    createGeometryArena();
     EngineLog::logger->trace("createDepthResources()");
     createDepthResources();
-    EngineLog::logger->trace("createTextureSampler()");
-    createTextureSampler();
     EngineLog::logger->trace("createUniformBuffers()");
     createUniformBuffers();
     EngineLog::logger->trace("createDescriptorPools()");
@@ -89,14 +112,45 @@ void GNVEngine::initVulkan()
     createCommandBuffers();
     EngineLog::logger->trace("createSyncObjects()");
     createSyncObjects();
-    EngineLog::logger->trace("initImGui()");
-    initImGui();
+    EngineLog::logger->trace("createTimestampQueryPool()");
+    createTimestampQueryPool();
+    if (!settings.headless) {
+        EngineLog::logger->trace("initImGui()");
+        initImGui();
+    }
     EngineLog::logger->trace("loadModel()");
+    auto loadStart = std::chrono::high_resolution_clock::now();
     loadModel();
+    double loadMs =
+        std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - loadStart).count();
+    benchmark.setLoadTime(loadMs);
+    EngineLog::logger->info("loadModel() took {:.2f} ms", loadMs);
+    EngineLog::logger->trace("createScene()");
+    createScene();
+    EngineLog::logger->trace("createObjectBuffers()");
+    createObjectBuffers();
+    EngineLog::logger->trace("buildSceneBvh()");
+    buildSceneBvh();
+    EngineLog::logger->trace("createFrameGraph()");
+    createFrameGraph();
+    if (settings.threadedSimulation) {
+        EngineLog::logger->trace("startSimulationThread()");
+        startSimulationThread();
+    }
+
+    double startupMs =
+        std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startupStart).count();
+    EngineLog::logger->info("Startup took {:.2f} ms, pipelines {:.2f} ms ({} pipeline cache)", startupMs, pipelineMs,
+                            pipelineCache.isWarm() ? "warm" : "cold");
 }
 
 void GNVEngine::mainLoop()
 {
+    if (settings.headless || settings.benchmarkFrames > 0) {
+        runBenchmark();
+        return;
+    }
+
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
         drawFrame();
@@ -115,9 +169,28 @@ void GNVEngine::cleanup()
 {
     device.waitIdle();
 
+    try {
+        pipelineCache.save();
+    } catch (const std::exception& e) {
+        // Losing the cache only costs the next startup some time
+        EngineLog::logger->warn("Failed to save pipeline cache: {}", e.what());
+    }
+
+    // The simulation thread goes first, it's what steps physics; then the step that may still be running on the pool
+    // is collected
+    if (simulationThread.joinable()) {
+        simulationThread.request_stop();
+        simulationThread.join();
+    }
+    meshCollision.clear();
+    physics.reset();
     meshManager.clear();
+    retiredTextures.clear();
     textureManager.clear();
-    textureSampler.clear();
+    samplers.clear();
+
+    if (settings.headless)
+        return;
 
     ImGui_ImplVulkan_Shutdown();
     ImGui_ImplGlfw_Shutdown();
@@ -218,6 +291,13 @@ void GNVEngine::createSurface()
 
 void GNVEngine::pickPhysicalDevice()
 {
+    // Headless rendering never presents, so don't reject devices (e.g. lavapipe without WSI) lacking a swapchain
+    if (settings.headless) {
+        std::erase_if(requiredDeviceExtension, [](const char* extension) {
+            return strcmp(extension, vk::KHRSwapchainExtensionName) == 0;
+        });
+    }
+
     std::vector<vk::raii::PhysicalDevice> devices = instance.enumeratePhysicalDevices();
     const auto devIter = std::ranges::find_if(devices, [&](auto const& device) {
         // Check if the device supports the Vulkan 1.3 API version
@@ -239,10 +319,14 @@ void GNVEngine::pickPhysicalDevice()
             });
 
         auto features = device.template getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan11Features,
+                                                     vk::PhysicalDeviceVulkan12Features,
                                                      vk::PhysicalDeviceVulkan13Features,
                                                      vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>();
         bool supportsRequiredFeatures =
             features.template get<vk::PhysicalDeviceVulkan11Features>().shaderDrawParameters &&
+            features.template get<vk::PhysicalDeviceFeatures2>().features.drawIndirectFirstInstance &&
+            features.template get<vk::PhysicalDeviceVulkan12Features>().timelineSemaphore &&
+            features.template get<vk::PhysicalDeviceVulkan12Features>().drawIndirectCount &&
             features.template get<vk::PhysicalDeviceVulkan13Features>().dynamicRendering &&
             features.template get<vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>().extendedDynamicState;
 
@@ -262,7 +346,7 @@ void GNVEngine::createLogicalDevice()
     // get the first index into queueFamilyProperties which supports both graphics and present
     for (uint32_t qfpIndex = 0; qfpIndex < queueFamilyProperties.size(); qfpIndex++) {
         if ((queueFamilyProperties[qfpIndex].queueFlags & vk::QueueFlagBits::eGraphics) &&
-            physicalDevice.getSurfaceSupportKHR(qfpIndex, *surface)) {
+            (settings.headless || physicalDevice.getSurfaceSupportKHR(qfpIndex, *surface))) {
             // found a queue family that supports both graphics and present
             queueIndex = qfpIndex;
             break;
@@ -272,16 +356,26 @@ void GNVEngine::createLogicalDevice()
         throw std::runtime_error("Could not find a queue for graphics and present -> terminating");
     }
 
-    // query for required features (Vulkan 1.1 and 1.3)
+    // query for required features (Vulkan 1.1, 1.2 and 1.3)
     vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan11Features,
-                       vk::PhysicalDeviceVulkan13Features, vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT,
-                       vk::PhysicalDeviceDescriptorIndexingFeatures>
+                       vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceVulkan13Features,
+                       vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>
         featureChain{};
-    featureChain.get<vk::PhysicalDeviceFeatures2>().features.setSamplerAnisotropy(VK_TRUE);
+    featureChain.get<vk::PhysicalDeviceFeatures2>().features.setSamplerAnisotropy(VK_TRUE).setDrawIndirectFirstInstance(
+        VK_TRUE);
+    // Block-compressed textures use whichever of these the device has, see chooseTranscodeTargets()
+    vk::PhysicalDeviceFeatures supportedFeatures = physicalDevice.getFeatures();
+    featureChain.get<vk::PhysicalDeviceFeatures2>()
+        .features.setTextureCompressionBC(supportedFeatures.textureCompressionBC)
+        .setTextureCompressionASTC_LDR(supportedFeatures.textureCompressionASTC_LDR)
+        .setTextureCompressionETC2(supportedFeatures.textureCompressionETC2);
     featureChain.get<vk::PhysicalDeviceVulkan11Features>().setShaderDrawParameters(VK_TRUE);
     featureChain.get<vk::PhysicalDeviceVulkan13Features>().setSynchronization2(VK_TRUE).setDynamicRendering(VK_TRUE);
     featureChain.get<vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>().setExtendedDynamicState(VK_TRUE);
-    featureChain.get<vk::PhysicalDeviceDescriptorIndexingFeatures>()
+    // Descriptor indexing lives in the Vulkan 1.2 struct, which can't be chained alongside the extension struct
+    featureChain.get<vk::PhysicalDeviceVulkan12Features>()
+        .setTimelineSemaphore(VK_TRUE)
+        .setDrawIndirectCount(VK_TRUE)
         .setRuntimeDescriptorArray(VK_TRUE)
         .setDescriptorBindingPartiallyBound(VK_TRUE)
         .setShaderSampledImageArrayNonUniformIndexing(VK_TRUE)
@@ -343,6 +437,24 @@ void GNVEngine::createImageViews()
     }
 }
 
+void GNVEngine::createOffscreenTargets()
+{
+    swapChainExtent = vk::Extent2D{ WIDTH, HEIGHT };
+    swapChainSurfaceFormat = vk::SurfaceFormatKHR{ vk::Format::eB8G8R8A8Unorm, vk::ColorSpaceKHR::eSrgbNonlinear };
+
+    offscreenImageViews.clear();
+    offscreenImages.clear();
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        GpuImage image = nullptr;
+        createImage(swapChainExtent.width, swapChainExtent.height, 1, swapChainSurfaceFormat.format,
+                    vk::ImageTiling::eOptimal,
+                    vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc, image);
+        offscreenImageViews.push_back(
+            createImageView(*image, swapChainSurfaceFormat.format, vk::ImageAspectFlagBits::eColor, 1));
+        offscreenImages.push_back(std::move(image));
+    }
+}
+
 void GNVEngine::createDescriptorPools()
 {
     vk::DescriptorPoolSize imGuipoolSize{};
@@ -359,13 +471,18 @@ void GNVEngine::createDescriptorPools()
 
     imGuidescriptorPool = vk::raii::DescriptorPool{ device, imGuipoolInfo };
 
+    // Per frame: the graphics set (UBO, objects, transforms, the whole bindless texture array) and the cull set
+    // (storage buffers only)
     std::array poolSize{ vk::DescriptorPoolSize(vk::DescriptorType::eUniformBuffer, MAX_FRAMES_IN_FLIGHT),
-                         vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, MAX_FRAMES_IN_FLIGHT) };
+                         vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer,
+                                                (2 + CULL_STORAGE_BUFFER_COUNT) * MAX_FRAMES_IN_FLIGHT),
+                         vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler,
+                                                bindlessTextures.getCapacity() * MAX_FRAMES_IN_FLIGHT) };
     vk::DescriptorPoolCreateInfo poolInfo{};
     poolInfo
         .setFlags(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet |
                   vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind)
-        .setMaxSets(MAX_FRAMES_IN_FLIGHT)
+        .setMaxSets(2 * MAX_FRAMES_IN_FLIGHT)
         .setPoolSizeCount(static_cast<uint32_t>(poolSize.size()))
         .setPPoolSizes(poolSize.data());
     descriptorPool = vk::raii::DescriptorPool(device, poolInfo);
@@ -402,7 +519,7 @@ void GNVEngine::initImGui()
     info.Device = *device;
     info.QueueFamily = queueIndex;
     info.Queue = *queue;
-    info.PipelineCache = VK_NULL_HANDLE;
+    info.PipelineCache = static_cast<VkPipelineCache>(*pipelineCache);
     info.DescriptorPool = *imGuidescriptorPool;
     info.MinImageCount = chooseSwapMinImageCount(surfaceCapabilities);
     info.ImageCount = swapChainImages.size();
@@ -421,14 +538,6 @@ void GNVEngine::createGraphicsPipeline()
     fragShaderStageInfo.setStage(vk::ShaderStageFlagBits::eFragment).setModule(shaderModule).setPName("fragMain");
     vk::PipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
 
-    auto bindingDescription = Vertex::getBindingDescription();
-    auto attributeDescriptions = Vertex::getAttributeDescriptions();
-    vk::PipelineVertexInputStateCreateInfo vertexInputInfo{};
-    vertexInputInfo.setVertexBindingDescriptionCount(1)
-        .setPVertexBindingDescriptions(&bindingDescription)
-        .setVertexAttributeDescriptionCount(static_cast<uint32_t>(attributeDescriptions.size()))
-        .setPVertexAttributeDescriptions(attributeDescriptions.data());
-
     vk::PipelineInputAssemblyStateCreateInfo inputAssembly{};
     inputAssembly.setTopology(vk::PrimitiveTopology::eTriangleList);
 
@@ -439,9 +548,10 @@ void GNVEngine::createGraphicsPipeline()
     rasterizer.setDepthClampEnable(vk::False)
         .setRasterizerDiscardEnable(vk::False)
         .setPolygonMode(vk::PolygonMode::eFill)
-        .setCullMode(vk::CullModeFlagBits::eNone)
-        // .setCullMode(vk::CullModeFlagBits::eBack)
-        // .setFrontFace(vk::FrontFace::eClockwise)
+        // glTF winds front faces counter-clockwise, which the flipped projection keeps on screen. The cull mode is
+        // set per draw, double-sided materials turn it off.
+        .setCullMode(vk::CullModeFlagBits::eBack)
+        .setFrontFace(vk::FrontFace::eCounterClockwise)
         .setDepthBiasEnable(vk::False)
         .setLineWidth(1.0f);
 
@@ -468,18 +578,14 @@ void GNVEngine::createGraphicsPipeline()
         .setAttachmentCount(1)
         .setPAttachments(&colorBlendAttachment);
 
-    std::vector dynamicStates = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+    std::vector dynamicStates = { vk::DynamicState::eViewport, vk::DynamicState::eScissor,
+                                  vk::DynamicState::eCullMode };
     vk::PipelineDynamicStateCreateInfo dynamicState{};
     dynamicState.setDynamicStateCount(static_cast<uint32_t>(dynamicStates.size()))
         .setPDynamicStates(dynamicStates.data());
 
-    vk::PushConstantRange pushConstantRange{};
-    pushConstantRange.setStageFlags(vk::ShaderStageFlagBits::eFragment).setOffset(0).setSize(sizeof(uint32_t));
     vk::PipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.setSetLayoutCount(1)
-        .setPushConstantRangeCount(1)
-        .setPPushConstantRanges(&pushConstantRange)
-        .setPSetLayouts(&*descriptorSetLayout);
+    pipelineLayoutInfo.setSetLayoutCount(1).setPSetLayouts(&*descriptorSetLayout);
 
     pipelineLayout = vk::raii::PipelineLayout(device, pipelineLayoutInfo);
 
@@ -490,98 +596,931 @@ void GNVEngine::createGraphicsPipeline()
         .setPColorAttachmentFormats(&swapChainSurfaceFormat.format)
         .setDepthAttachmentFormat(depthFormat);
 
-    vk::GraphicsPipelineCreateInfo pipelineCreateInfo{};
-    pipelineCreateInfo.setStageCount(2)
-        .setPStages(shaderStages)
-        .setPVertexInputState(&vertexInputInfo)
-        .setPInputAssemblyState(&inputAssembly)
-        .setPViewportState(&viewportState)
-        .setPRasterizationState(&rasterizer)
-        .setPMultisampleState(&multisampling)
-        .setPDepthStencilState(&depthStencil)
-        .setPColorBlendState(&colorBlending)
-        .setPDynamicState(&dynamicState)
-        .setLayout(pipelineLayout)
-        .setRenderPass(nullptr)
-        .setPNext(&pipelineRenderingInfo);
+    // Same shader for every vertex format, the vertex input widens packed attributes and the per-object transform
+    // dequantizes them. Each instance reads the index of the object it draws from a second binding.
+    for (VertexFormat format : { VertexFormat::Float, VertexFormat::Packed }) {
+        bool packed = format == VertexFormat::Packed;
+        std::array bindingDescriptions = {
+            packed ? PackedVertex::getBindingDescription() : Vertex::getBindingDescription(),
+            vk::VertexInputBindingDescription(INSTANCE_BINDING, sizeof(uint32_t), vk::VertexInputRate::eInstance)
+        };
+        auto vertexAttributes = packed ? PackedVertex::getAttributeDescriptions() : Vertex::getAttributeDescriptions();
+        std::vector<vk::VertexInputAttributeDescription> attributeDescriptions(vertexAttributes.begin(),
+                                                                              vertexAttributes.end());
+        attributeDescriptions.emplace_back(static_cast<uint32_t>(vertexAttributes.size()), INSTANCE_BINDING,
+                                           vk::Format::eR32Uint, 0);
+        vk::PipelineVertexInputStateCreateInfo vertexInputInfo{};
+        vertexInputInfo.setVertexBindingDescriptionCount(static_cast<uint32_t>(bindingDescriptions.size()))
+            .setPVertexBindingDescriptions(bindingDescriptions.data())
+            .setVertexAttributeDescriptionCount(static_cast<uint32_t>(attributeDescriptions.size()))
+            .setPVertexAttributeDescriptions(attributeDescriptions.data());
+
+        vk::GraphicsPipelineCreateInfo pipelineCreateInfo{};
+        pipelineCreateInfo.setStageCount(2)
+            .setPStages(shaderStages)
+            .setPVertexInputState(&vertexInputInfo)
+            .setPInputAssemblyState(&inputAssembly)
+            .setPViewportState(&viewportState)
+            .setPRasterizationState(&rasterizer)
+            .setPMultisampleState(&multisampling)
+            .setPDepthStencilState(&depthStencil)
+            .setPColorBlendState(&colorBlending)
+            .setPDynamicState(&dynamicState)
+            .setLayout(pipelineLayout)
+            .setRenderPass(nullptr)
+            .setPNext(&pipelineRenderingInfo);
+
+        graphicsPipelines[static_cast<size_t>(format)] =
+            vk::raii::Pipeline(device, pipelineCache.getCache(), pipelineCreateInfo);
+    }
+}
+
+void GNVEngine::createCullPipeline()
+{
+    // Objects, commands, counts, LODs, LOD states, meshlets, cluster work, the cluster dispatch and the per-object
+    // transforms, in that order
+    std::array<vk::DescriptorSetLayoutBinding, CULL_STORAGE_BUFFER_COUNT> bindings{};
+    for (uint32_t b = 0; b < CULL_STORAGE_BUFFER_COUNT; ++b) {
+        bindings[b] = vk::DescriptorSetLayoutBinding(b, vk::DescriptorType::eStorageBuffer, 1,
+                                                     vk::ShaderStageFlagBits::eCompute, nullptr);
+    }
+    vk::DescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.setBindingCount(static_cast<uint32_t>(bindings.size())).setPBindings(bindings.data());
+    cullDescriptorSetLayout = vk::raii::DescriptorSetLayout(device, layoutInfo);
 
-    graphicsPipeline = vk::raii::Pipeline(device, nullptr, pipelineCreateInfo);
+    vk::PushConstantRange pushConstantRange{};
+    pushConstantRange.setStageFlags(vk::ShaderStageFlagBits::eCompute)
+        .setOffset(0)
+        .setSize(sizeof(CullPushConstants));
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.setSetLayoutCount(1)
+        .setPSetLayouts(&*cullDescriptorSetLayout)
+        .setPushConstantRangeCount(1)
+        .setPPushConstantRanges(&pushConstantRange);
+    cullPipelineLayout = vk::raii::PipelineLayout(device, pipelineLayoutInfo);
+
+    // Both passes share the layout, the object pass only leaves the meshlet bindings alone
+    vk::raii::ShaderModule shaderModule = createShaderModule(readFile(CULL_SHADER_PATH));
+    vk::PipelineShaderStageCreateInfo stageInfo{};
+    stageInfo.setStage(vk::ShaderStageFlagBits::eCompute).setModule(shaderModule).setPName("cullMain");
+
+    vk::ComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.setStage(stageInfo).setLayout(cullPipelineLayout);
+    cullPipeline = vk::raii::Pipeline(device, pipelineCache.getCache(), pipelineInfo);
+
+    stageInfo.setPName("clusterCullMain");
+    pipelineInfo.setStage(stageInfo);
+    clusterCullPipeline = vk::raii::Pipeline(device, pipelineCache.getCache(), pipelineInfo);
 }
 
-void GNVEngine::createCommandPool()
+void GNVEngine::createScene()
 {
-    vk::CommandPoolCreateInfo poolInfo{};
-    poolInfo.setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer).setQueueFamilyIndex(queueIndex);
-    commandPool = vk::raii::CommandPool(device, poolInfo);
+    const std::vector<CookedNode>& nodes = model.getNodes();
+    uint32_t copies = std::max(settings.modelCopies, 1u);
+    objectMeshes.clear();
+    std::vector<entt::entity> entities(nodes.size());
+    auto instantiateModel = [&] {
+        entt::entity root = scene.createNode(entt::null, glm::mat4(1.0f));
+        for (size_t n = 0; n < nodes.size(); ++n) {
+            const CookedNode& node = nodes[n];
+            glm::mat4 local{};
+            memcpy(&local[0][0], node.matrix.data(), sizeof(local));
+            entities[n] = scene.createNode(node.parent >= 0 ? entities[node.parent] : root, local);
+            if (node.meshCount == 0)
+                continue;
+            scene.getRegistry().emplace<MeshInstance>(entities[n], static_cast<uint32_t>(objectMeshes.size()),
+                                                      node.meshCount);
+            for (uint32_t m = 0; m < node.meshCount; ++m)
+                objectMeshes.push_back(node.firstMesh + m);
+        }
+        return root;
+    };
+
+    // Copies are a model's width and a bit apart on the ground plane, measured from the first one where it landed
+    std::vector<entt::entity> roots{ instantiateModel() };
+    scene.update();
+    auto instances = scene.getRegistry().view<MeshInstance, WorldTransform>();
+    modelBounds = Aabb{};
+    for (auto [entity, instance, world] : instances.each()) {
+        for (uint32_t o = instance.firstObject; o < instance.firstObject + instance.objectCount; ++o)
+            modelBounds.expand(ObjectTransform::of(meshManager[objectMeshes[o]].bounds, world.matrix).getBounds());
+    }
+    glm::vec3 spacing = modelBounds.valid() ? (modelBounds.max - modelBounds.min) * 1.25f : glm::vec3(1.0f);
+    uint32_t gridSide = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(copies))));
+    for (uint32_t copy = 1; copy < copies; ++copy) {
+        glm::vec3 offset{ static_cast<float>(copy % gridSide) * spacing.x, 0.0f,
+                          static_cast<float>(copy / gridSide) * spacing.z };
+        roots.push_back(instantiateModel());
+        scene.setLocalTransform(roots.back(), glm::translate(glm::mat4(1.0f), offset));
+    }
+
+    std::vector<entt::entity> bodyRoots;
+    for (uint32_t body = 0; body < settings.physicsBodies; ++body)
+        bodyRoots.push_back(instantiateModel());
+    createPhysics(bodyRoots);
+
+    objectCount = static_cast<uint32_t>(objectMeshes.size());
+    objectTransforms.assign(objectCount, ObjectTransform{});
+    scene.update();
+    for (auto [entity, instance, world] : instances.each()) {
+        for (uint32_t o = instance.firstObject; o < instance.firstObject + instance.objectCount; ++o)
+            objectTransforms[o] = ObjectTransform::of(meshManager[objectMeshes[o]].bounds, world.matrix);
+    }
+    EngineLog::logger->info("Scene: {} nodes, {} objects, {} physics bodies", scene.getNodeCount(), objectCount,
+                            bodyRoots.size());
 }
 
-void GNVEngine::createVertexBuffer(Mesh& mesh)
+void GNVEngine::createPhysics(std::span<const entt::entity> bodyRoots)
 {
-    vk::DeviceSize bufferSize = sizeof(mesh.vertices[0]) * mesh.vertices.size();
-    vk::raii::Buffer stagingBuffer{ nullptr };
-    vk::raii::DeviceMemory stagingBufferMemory{ nullptr };
-    createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferSrc,
-                 vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingBuffer,
-                 stagingBufferMemory);
-    void* dataStaging = stagingBufferMemory.mapMemory(0, bufferSize);
-    memcpy(dataStaging, mesh.vertices.data(), bufferSize);
-    stagingBufferMemory.unmapMemory();
+    if (bodyRoots.empty())
+        return;
+
+    uint32_t copies = std::max(settings.modelCopies, 1u);
+    uint32_t bodyCount = static_cast<uint32_t>(bodyRoots.size());
+    physics = std::make_unique<PhysicsWorld>(threadPool, bodyCount + copies + 1, PHYSICS_TIMESTEP,
+                                             PHYSICS_MAX_STEPS_PER_FRAME);
+    cookCollisionShapes();
+
+    // The model's shapes in the space of its root, from the first copy, which sits at the origin
+    std::vector<CollisionPart> staticParts;
+    std::vector<CollisionPart> dynamicParts;
+    size_t copyObjects = objectMeshes.size() / (copies + bodyCount);
+    for (auto [entity, instance, world] : scene.getRegistry().view<MeshInstance, WorldTransform>().each()) {
+        for (uint32_t o = instance.firstObject; o < instance.firstObject + instance.objectCount; ++o) {
+            if (o >= copyObjects)
+                continue;
+            const MeshCollision& collision = meshCollision[objectMeshes[o]];
+            staticParts.push_back(CollisionPart{ collision.mesh, world.matrix });
+            dynamicParts.push_back(CollisionPart{ collision.hull, world.matrix });
+        }
+    }
+    JPH::ShapeRefC staticShape = createCompoundShape(staticParts);
+    JPH::ShapeRefC dynamicShape = createCompoundShape(dynamicParts);
+    if (staticShape == nullptr || dynamicShape == nullptr) {
+        EngineLog::logger->warn("The model has no triangles to collide with, physics is disabled");
+        physics.reset();
+        return;
+    }
 
-    createBuffer(bufferSize, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
-                 vk::MemoryPropertyFlagBits::eDeviceLocal, mesh.vertexBuffer, mesh.vertexBufferMemory);
-    copyBuffer(stagingBuffer, mesh.vertexBuffer, bufferSize);
+    // Every copy on the grid collides with its triangles, on a ground as wide as the grid and then some
+    glm::vec3 halfExtent = glm::max((modelBounds.max - modelBounds.min) * 0.5f, glm::vec3(0.05f));
+    glm::vec3 center = (modelBounds.min + modelBounds.max) * 0.5f;
+    glm::vec3 spacing = halfExtent * 2.5f;
+    uint32_t gridSide = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(copies))));
+    glm::vec3 gridCenter = center + glm::vec3(static_cast<float>(gridSide - 1) * 0.5f * spacing.x, 0.0f,
+                                              static_cast<float>(gridSide - 1) * 0.5f * spacing.z);
+    for (uint32_t copy = 0; copy < copies; ++copy) {
+        physics->addStaticShape(staticShape, glm::vec3(static_cast<float>(copy % gridSide) * spacing.x, 0.0f,
+                                                       static_cast<float>(copy / gridSide) * spacing.z));
+    }
+    float groundHalfWidth = (static_cast<float>(gridSide) + 4.0f) * std::max(spacing.x, spacing.z);
+    glm::vec3 groundHalfExtent{ groundHalfWidth, std::max(halfExtent.y, 0.5f), groundHalfWidth };
+    physics->addStaticBox(glm::vec3(gridCenter.x, modelBounds.min.y - groundHalfExtent.y, gridCenter.z),
+                          groundHalfExtent);
+
+    // Bodies start as a cube of models a little apart above the grid, turned a little further each so they tumble.
+    // Each is placed so that the center of its model's bounds lands on its cell.
+    uint32_t side = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<double>(bodyCount))));
+    glm::vec3 origin = gridCenter - glm::vec3(static_cast<float>(side - 1) * 0.5f * spacing.x, 0.0f,
+                                              static_cast<float>(side - 1) * 0.5f * spacing.z);
+    origin.y = modelBounds.max.y + spacing.y;
+    for (uint32_t b = 0; b < bodyCount; ++b) {
+        glm::vec3 cell{ static_cast<float>(b % side), static_cast<float>(b / (side * side)),
+                        static_cast<float>(b / side % side) };
+        glm::quat rotation =
+            glm::angleAxis(static_cast<float>(b) * 0.618f, glm::normalize(glm::vec3(1.0f, 0.0f, 1.0f)));
+        uint32_t body = physics->addDynamicShape(dynamicShape, origin + cell * spacing - rotation * center, rotation);
+        scene.getRegistry().emplace<RigidBody>(bodyRoots[b], body);
+        bodyNodes.push_back(bodyRoots[b]);
+        scene.setLocalTransform(bodyRoots[b], physics->getTransform(body));
+    }
+    lastSceneUpdate = std::chrono::high_resolution_clock::now();
 }
 
-void GNVEngine::createIndexBuffer(Mesh& mesh)
+void GNVEngine::cookCollisionShapes()
 {
-    vk::DeviceSize bufferSize = sizeof(mesh.indices[0]) * mesh.indices.size();
+    using Clock = std::chrono::high_resolution_clock;
+    auto start = Clock::now();
+
+    // One job per distinct shape, meshes with the same triangles share theirs
+    struct ShapeJob {
+        size_t geometry;
+        CollisionShapeKind kind;
+        uint64_t key;
+        JPH::ShapeRefC shape;
+        bool cached = false;
+    };
+    // Level 0 of each mesh, decoded and hashed on the workers
+    std::vector<CollisionGeometry> geometry(meshManager.size());
+    std::vector<std::array<uint64_t, 2>> keys(meshManager.size());
+    BS::multi_future<void> decodeTasks = threadPool.submit_loop<size_t>(0, meshManager.size(), [&](size_t m) {
+        const Mesh& mesh = meshManager[m];
+        CollisionGeometry& g = geometry[m];
+        g.positions.resize(mesh.vertexCount);
+        for (uint32_t v = 0; v < mesh.vertexCount; ++v)
+            g.positions[v] = mesh.getVertex(v).pos;
+        const MeshLod& lod = mesh.lods.front();
+        g.indices.resize(lod.indexCount);
+        for (uint32_t i = 0; i < lod.indexCount; ++i)
+            g.indices[i] = mesh.getIndex(lod.firstIndex + i);
+        keys[m] = { hashCollisionGeometry(g, CollisionShapeKind::Mesh),
+                    hashCollisionGeometry(g, CollisionShapeKind::ConvexHull) };
+    });
+    decodeTasks.wait();
+    decodeTasks.get();
+
+    std::vector<ShapeJob> jobs;
+    std::unordered_map<uint64_t, size_t> jobIndices;
+    std::vector<std::array<size_t, 2>> meshJobs(meshManager.size());
+    for (size_t m = 0; m < meshManager.size(); ++m) {
+        for (CollisionShapeKind kind : { CollisionShapeKind::Mesh, CollisionShapeKind::ConvexHull }) {
+            uint64_t key = keys[m][static_cast<size_t>(kind)];
+            auto [it, inserted] = jobIndices.try_emplace(key, jobs.size());
+            if (inserted)
+                jobs.push_back(ShapeJob{ m, kind, key, nullptr });
+            meshJobs[m][static_cast<size_t>(kind)] = it->second;
+        }
+    }
 
-    vk::raii::Buffer stagingBuffer({});
-    vk::raii::DeviceMemory stagingBufferMemory({});
-    createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferSrc,
-                 vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingBuffer,
-                 stagingBufferMemory);
+    // Every shape is loaded or cooked on its own. A mesh Jolt fails on doesn't collide, a failed save only costs the
+    // next run a cook.
+    CollisionShapeCache cache{ COLLISION_SHAPE_DIR };
+    BS::multi_future<void> shapeTasks = threadPool.submit_loop<size_t>(0, jobs.size(), [&](size_t j) {
+        ShapeJob& job = jobs[j];
+        job.shape = cache.load(job.key);
+        job.cached = job.shape != nullptr;
+        if (job.cached)
+            return;
+        try {
+            job.shape = cookCollisionShape(geometry[job.geometry], job.kind);
+            if (job.shape != nullptr)
+                cache.save(job.key, *job.shape);
+        } catch (const std::exception& e) {
+            EngineLog::logger->warn("Collision shape for mesh {}: {}", job.geometry, e.what());
+        }
+    });
+    shapeTasks.wait();
+    shapeTasks.get();
+
+    meshCollision.assign(meshManager.size(), MeshCollision{});
+    for (size_t m = 0; m < meshManager.size(); ++m) {
+        meshCollision[m].mesh = jobs[meshJobs[m][0]].shape;
+        meshCollision[m].hull = jobs[meshJobs[m][1]].shape;
+    }
+    size_t cachedCount = std::ranges::count_if(jobs, [](const ShapeJob& job) { return job.cached; });
+    EngineLog::logger->info("Collision shapes ({}): {} shapes for {} meshes, {} cooked, {} from cache, {:.2f} ms "
+                            "({} threads)",
+                            cachedCount == jobs.size() ? "warm" : "cold", jobs.size(), meshManager.size(),
+                            jobs.size() - cachedCount, cachedCount,
+                            std::chrono::duration<double, std::milli>(Clock::now() - start).count(),
+                            threadPool.get_thread_count());
+}
+
+void GNVEngine::updateScene()
+{
+    if (!settings.threadedSimulation) {
+        simulationStats = simulateScene(objectTransforms, movedObjects);
+        for (uint32_t object : movedObjects)
+            sceneBvh.update(object, objectTransforms[object].getBounds());
+        return;
+    }
+
+    if (simulationFailed)
+        throw std::runtime_error("simulation thread failed!");
+    using Clock = std::chrono::high_resolution_clock;
+    bool acquired = snapshots.acquire();
+    if (acquired) {
+        // What was on its way comes to rest where it was going, which is where it starts from towards the new one
+        const RenderSnapshot& snapshot = snapshots.read();
+        for (uint32_t o : interpolatedObjects) {
+            fromTransforms[o] = toTransforms[o];
+            objectTransforms[o] = toTransforms[o];
+            sceneBvh.update(o, objectTransforms[o].getBounds());
+        }
+        interpolatedObjects.clear();
+        if (snapshot.transformsVersion != toVersion) {
+            toVersion = snapshot.transformsVersion;
+            for (uint32_t o = 0; o < objectCount; ++o) {
+                if (memcmp(&toTransforms[o], &snapshot.objectTransforms[o], sizeof(ObjectTransform)) == 0)
+                    continue;
+                toTransforms[o] = snapshot.objectTransforms[o];
+                interpolatedObjects.push_back(o);
+            }
+        }
+        fromTime = toTime;
+        toTime = snapshot.time;
+        simulationStats = snapshot.stats;
+        simulationTick = snapshot.tick;
+    }
+
+    // Drawn a tick behind the simulation, so the snapshot to interpolate towards has usually arrived already
+    auto tickLength = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(PHYSICS_TIMESTEP));
+    float span = std::chrono::duration<float>(toTime - fromTime).count();
+    float elapsed = std::chrono::duration<float>(Clock::now() - tickLength - fromTime).count();
+    float alpha = span > 0.0f ? std::clamp(elapsed / span, 0.0f, 1.0f) : 1.0f;
+    if (!acquired && alpha == interpolationAlpha)
+        return;
+    interpolationAlpha = alpha;
+    for (uint32_t o : interpolatedObjects) {
+        objectTransforms[o] = ObjectTransform::interpolate(meshManager[objectMeshes[o]].bounds, fromTransforms[o],
+                                                           toTransforms[o], alpha);
+        sceneBvh.update(o, objectTransforms[o].getBounds());
+    }
+}
+
+SimulationStats GNVEngine::simulateScene(std::span<ObjectTransform> transforms, std::vector<uint32_t>& moved)
+{
+    // Only moved nodes get extracted into their objects' transforms
+    auto start = std::chrono::high_resolution_clock::now();
+    SimulationStats stats{};
+    if (physics) {
+        float elapsed = std::chrono::duration<float>(start - lastSceneUpdate).count();
+        lastSceneUpdate = start;
+        physics->update(elapsed);
+        // Sleeping bodies keep their nodes' transforms, so they don't dirty the scene every frame
+        for (uint32_t body : physics->getMovedBodies())
+            scene.setLocalTransform(bodyNodes[body], physics->getTransform(body));
+        stats.physicsActiveBodies = physics->getActiveBodyCount();
+        stats.physicsSteps = physics->getStepCount();
+        stats.physicsStepMs = physics->getStepMs();
+    }
+    moved.clear();
+    stats.changedNodes = scene.update();
+    if (stats.changedNodes > 0) {
+        for (auto [entity, instance, world] : scene.getRegistry().view<MeshInstance, WorldTransform>().each()) {
+            if (!world.changed)
+                continue;
+            for (uint32_t o = instance.firstObject; o < instance.firstObject + instance.objectCount; ++o) {
+                transforms[o] = ObjectTransform::of(meshManager[objectMeshes[o]].bounds, world.matrix);
+                moved.push_back(o);
+            }
+        }
+    }
+    stats.updateMicros =
+        std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+    return stats;
+}
 
-    void* data = stagingBufferMemory.mapMemory(0, bufferSize);
-    memcpy(data, mesh.indices.data(), (size_t)bufferSize);
-    stagingBufferMemory.unmapMemory();
+void GNVEngine::startSimulationThread()
+{
+    simulationTransforms = objectTransforms;
+    fromTransforms = objectTransforms;
+    toTransforms = objectTransforms;
+    lastSceneUpdate = std::chrono::high_resolution_clock::now();
+    fromTime = lastSceneUpdate;
+    toTime = lastSceneUpdate;
+    simulationThread = std::jthread([this](std::stop_token stop) { runSimulation(stop); });
+    EngineLog::logger->info("Simulation runs on its own thread at {:.0f} Hz", 1.0f / PHYSICS_TIMESTEP);
+}
 
-    createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer,
-                 vk::MemoryPropertyFlagBits::eDeviceLocal, mesh.indexBuffer, mesh.indexBufferMemory);
+void GNVEngine::runSimulation(std::stop_token stop)
+{
+    // One tick per physics step, a tick that overruns starts the next one right away instead of trying to catch up
+    using Clock = std::chrono::high_resolution_clock;
+    auto tickLength = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(PHYSICS_TIMESTEP));
+    auto nextTick = Clock::now();
+    std::vector<uint32_t> moved;
+    // Ahead of the empty slots' version, so the first tick fills them
+    uint64_t transformsVersion = 1;
+    try {
+        for (uint64_t tick = 1; !stop.stop_requested(); ++tick) {
+            auto tickStart = Clock::now();
+            SimulationStats stats = simulateScene(simulationTransforms, moved);
+            if (!moved.empty())
+                ++transformsVersion;
+            // The slot holds what was published three ticks ago, once the scene rests for that long it's current
+            RenderSnapshot& snapshot = snapshots.beginWrite();
+            snapshot.tick = tick;
+            snapshot.time = tickStart;
+            if (snapshot.transformsVersion != transformsVersion) {
+                snapshot.objectTransforms.assign(simulationTransforms.begin(), simulationTransforms.end());
+                snapshot.transformsVersion = transformsVersion;
+            }
+            snapshot.stats = stats;
+            snapshots.publish();
 
-    copyBuffer(stagingBuffer, mesh.indexBuffer, bufferSize);
+            nextTick = std::max(nextTick + tickLength, Clock::now());
+            std::this_thread::sleep_until(nextTick);
+        }
+    } catch (const std::exception& e) {
+        EngineLog::logger->error("Simulation thread: {}", e.what());
+        simulationFailed = true;
+    }
 }
 
-uint32_t GNVEngine::findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties)
+void GNVEngine::createObjectBuffers()
 {
-    vk::PhysicalDeviceMemoryProperties memProperties = physicalDevice.getMemoryProperties();
+    // LODs and meshlets are per mesh, every object of a mesh points at the same run
+    std::vector<LodData> lods;
+    std::vector<MeshletData> meshlets;
+    std::vector<uint32_t> meshLodBases;
+    for (const Mesh& mesh : meshManager) {
+        meshLodBases.push_back(static_cast<uint32_t>(lods.size()));
+        uint32_t meshletBase = static_cast<uint32_t>(meshlets.size());
+        for (const MeshLod& lod : mesh.lods) {
+            lods.push_back(LodData{ mesh.geometry.firstIndex + lod.firstIndex, lod.indexCount, lod.error,
+                                    meshletBase + lod.firstMeshlet, lod.meshletCount });
+        }
+        for (const CookedMeshlet& meshlet : mesh.meshlets) {
+            MeshletData& data = meshlets.emplace_back();
+            data.sphere = glm::vec4(meshlet.center[0], meshlet.center[1], meshlet.center[2], meshlet.radius);
+            data.cone = glm::vec4(meshlet.coneApex[0], meshlet.coneApex[1], meshlet.coneApex[2], meshlet.coneCutoff);
+            data.coneAxis = glm::vec4(meshlet.coneAxis[0], meshlet.coneAxis[1], meshlet.coneAxis[2], 0.0f);
+            data.firstIndex = mesh.geometry.firstIndex + meshlet.firstIndex;
+            data.indexCount = meshlet.triangleCount * 3;
+        }
+    }
 
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
+    // Draws are bucketed by arena page, vertex format and index type since an indirect draw can only use the
+    // buffers and pipeline bound for it. Each bucket owns a run of command slots, enough for each of its objects to
+    // draw every meshlet of its largest LOD.
+    drawBuckets.clear();
+    std::vector<uint32_t> pageBuckets(geometry.getPageCount() * VERTEX_FORMAT_COUNT * 4, UINT32_MAX);
+    std::vector<ObjectData> objects(objectCount);
+    sceneTriangles = 0;
+    for (uint32_t i = 0; i < objectCount; ++i) {
+        const Mesh& mesh = meshManager[objectMeshes[i]];
+        size_t key = ((mesh.geometry.page * VERTEX_FORMAT_COUNT + static_cast<size_t>(mesh.vertexFormat)) * 2 +
+                      (mesh.indexType == vk::IndexType::eUint16 ? 0 : 1)) * 2 +
+                     (mesh.doubleSided ? 1 : 0);
+        uint32_t& bucket = pageBuckets[key];
+        if (bucket == UINT32_MAX) {
+            bucket = static_cast<uint32_t>(drawBuckets.size());
+            drawBuckets.push_back(
+                DrawBucket{ mesh.geometry.page, mesh.vertexFormat, mesh.indexType, mesh.doubleSided, 0, 0 });
         }
+        uint32_t maxDraws = 1;
+        for (const MeshLod& lod : mesh.lods)
+            maxDraws = std::max(maxDraws, lod.meshletCount);
+        drawBuckets[bucket].capacity += maxDraws;
+
+        ObjectData& object = objects[i];
+        object.boundsMin = glm::vec4(mesh.bounds.min, 1.0f);
+        object.boundsMax = glm::vec4(mesh.bounds.max, 1.0f);
+        object.positionOffset = glm::vec4(mesh.positionOffset, 0.0f);
+        object.positionScale = glm::vec4(mesh.positionScale, 0.0f);
+        object.uvTransform = mesh.uvTransform;
+        object.indexCount = mesh.geometry.indexCount;
+        object.firstIndex = mesh.geometry.firstIndex;
+        object.vertexOffset = mesh.geometry.firstVertex;
+        object.textureIndex = textureManager.empty() ? 0 : textureManager[mesh.textureIndex].slot;
+        object.bucket = bucket;
+        object.lodBase = meshLodBases[objectMeshes[i]];
+        object.lodCount = static_cast<uint32_t>(mesh.lods.size());
+        object.doubleSided = mesh.doubleSided ? 1 : 0;
+        if (!mesh.lods.empty())
+            sceneTriangles += mesh.lods[0].indexCount / 3;
+    }
+    uint32_t commandBase = 0;
+    for (auto& bucket : drawBuckets) {
+        bucket.commandBase = commandBase;
+        commandBase += bucket.capacity;
     }
+    for (auto& object : objects)
+        object.commandBase = drawBuckets[object.bucket].commandBase;
+
+    vk::DeviceSize objectBytes = sizeof(ObjectData) * std::max(objectCount, 1u);
+    createBuffer(objectBytes, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, 0,
+                 objectBuffer);
+    if (!objects.empty())
+        uploads.uploadBuffer(objects.data(), sizeof(ObjectData) * objects.size(), *objectBuffer);
+
+    std::vector<uint32_t> objectIndices(objectCount);
+    std::iota(objectIndices.begin(), objectIndices.end(), 0u);
+    createBuffer(sizeof(uint32_t) * std::max(objectCount, 1u),
+                 vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst, 0, objectIndexBuffer);
+    if (!objectIndices.empty())
+        uploads.uploadBuffer(objectIndices.data(), sizeof(uint32_t) * objectIndices.size(), *objectIndexBuffer);
+
+    createBuffer(sizeof(LodData) * std::max<size_t>(lods.size(), 1),
+                 vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, 0, lodBuffer);
+    if (!lods.empty())
+        uploads.uploadBuffer(lods.data(), sizeof(LodData) * lods.size(), *lodBuffer);
+    // Every object starts out at full resolution, on both paths
+    objectLods.assign(objectCount, 0);
+    createBuffer(sizeof(uint32_t) * std::max(objectCount, 1u),
+                 vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, 0, lodStateBuffer);
+    if (!objectLods.empty())
+        uploads.uploadBuffer(objectLods.data(), sizeof(uint32_t) * objectLods.size(), *lodStateBuffer);
+
+    meshletCount = static_cast<uint32_t>(meshlets.size());
+    createBuffer(sizeof(MeshletData) * std::max<size_t>(meshlets.size(), 1),
+                 vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, 0, meshletBuffer);
+    if (!meshlets.empty())
+        uploads.uploadBuffer(meshlets.data(), sizeof(MeshletData) * meshlets.size(), *meshletBuffer);
+
+    vk::DeviceSize commandBytes = sizeof(vk::DrawIndexedIndirectCommand) * std::max(commandBase, 1u);
+    // One count per bucket, then the drawn triangle and visible object counters
+    vk::DeviceSize countBytes = sizeof(uint32_t) * (drawBuckets.size() + 2);
+    // Every transform and, on the CPU path, an instance per visible object, each allocation padded out to alignment
+    vk::DeviceSize frameAlignment = physicalDevice.getProperties().limits.minStorageBufferOffsetAlignment;
+    vk::DeviceSize frameBytes = (sizeof(ObjectTransform) + sizeof(uint32_t)) * objectCount + 2 * frameAlignment;
+    frameAllocator = FrameAllocator(*allocator,
+                                    vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer,
+                                    std::max(FRAME_ALLOCATOR_SIZE, frameBytes), MAX_FRAMES_IN_FLIGHT, frameAlignment);
+    drawCommandBuffers.clear();
+    drawCountBuffers.clear();
+    clusterWorkBuffers.clear();
+    clusterDispatchBuffers.clear();
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        GpuBuffer work = nullptr;
+        createBuffer(sizeof(ClusterWork) * std::max(objectCount, 1u), vk::BufferUsageFlagBits::eStorageBuffer, 0,
+                     work);
+        clusterWorkBuffers.push_back(std::move(work));
+        GpuBuffer dispatch = nullptr;
+        createBuffer(sizeof(vk::DispatchIndirectCommand),
+                     vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer |
+                         vk::BufferUsageFlagBits::eTransferDst,
+                     0, dispatch);
+        clusterDispatchBuffers.push_back(std::move(dispatch));
+
+        GpuBuffer commands = nullptr;
+        createBuffer(commandBytes, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer,
+                     0, commands);
+        drawCommandBuffers.push_back(std::move(commands));
+
+        // Host-readable so the visible count can be read back once the frame's fence has signaled
+        GpuBuffer counts = nullptr;
+        createBuffer(countBytes,
+                     vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer |
+                         vk::BufferUsageFlagBits::eTransferDst,
+                     VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT, counts);
+        memset(counts.getMapped(), 0, countBytes);
+        counts.flush();
+        drawCountBuffers.push_back(std::move(counts));
+    }
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        vk::DescriptorBufferInfo objectInfo{};
+        objectInfo.setBuffer(*objectBuffer).setOffset(0).setRange(VK_WHOLE_SIZE);
+        vk::DescriptorBufferInfo commandInfo{};
+        commandInfo.setBuffer(*drawCommandBuffers[i]).setOffset(0).setRange(VK_WHOLE_SIZE);
+        vk::DescriptorBufferInfo countInfo{};
+        countInfo.setBuffer(*drawCountBuffers[i]).setOffset(0).setRange(VK_WHOLE_SIZE);
+        vk::DescriptorBufferInfo lodInfo{};
+        lodInfo.setBuffer(*lodBuffer).setOffset(0).setRange(VK_WHOLE_SIZE);
+        vk::DescriptorBufferInfo lodStateInfo{};
+        lodStateInfo.setBuffer(*lodStateBuffer).setOffset(0).setRange(VK_WHOLE_SIZE);
+        vk::DescriptorBufferInfo meshletInfo{};
+        meshletInfo.setBuffer(*meshletBuffer).setOffset(0).setRange(VK_WHOLE_SIZE);
+        vk::DescriptorBufferInfo workInfo{};
+        workInfo.setBuffer(*clusterWorkBuffers[i]).setOffset(0).setRange(VK_WHOLE_SIZE);
+        vk::DescriptorBufferInfo dispatchInfo{};
+        dispatchInfo.setBuffer(*clusterDispatchBuffers[i]).setOffset(0).setRange(VK_WHOLE_SIZE);
+
+        auto storageWrite = [](const vk::raii::DescriptorSet& set, uint32_t binding,
+                               const vk::DescriptorBufferInfo& info) {
+            vk::WriteDescriptorSet write{};
+            write.setDstSet(*set)
+                .setDstBinding(binding)
+                .setDescriptorCount(1)
+                .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+                .setPBufferInfo(&info);
+            return write;
+        };
+        std::array writes = { storageWrite(descriptorSets[i], 1, objectInfo),
+                              storageWrite(cullDescriptorSets[i], 0, objectInfo),
+                              storageWrite(cullDescriptorSets[i], 1, commandInfo),
+                              storageWrite(cullDescriptorSets[i], 2, countInfo),
+                              storageWrite(cullDescriptorSets[i], 3, lodInfo),
+                              storageWrite(cullDescriptorSets[i], 4, lodStateInfo),
+                              storageWrite(cullDescriptorSets[i], 5, meshletInfo),
+                              storageWrite(cullDescriptorSets[i], 6, workInfo),
+                              storageWrite(cullDescriptorSets[i], 7, dispatchInfo) };
+        device.updateDescriptorSets(writes, {});
+    }
+}
+
+ObjectTransform ObjectTransform::of(const Aabb& bounds, const glm::mat4& model)
+{
+    Aabb moved = bounds;
+    if (bounds.valid()) {
+        moved = Aabb{};
+        for (int corner = 0; corner < 8; ++corner) {
+            glm::vec3 point{ corner & 1 ? bounds.max.x : bounds.min.x, corner & 2 ? bounds.max.y : bounds.min.y,
+                             corner & 4 ? bounds.max.z : bounds.min.z };
+            moved.expand(glm::vec3(model * glm::vec4(point, 1.0f)));
+        }
+    }
+    glm::vec3 scale{ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])),
+                     glm::length(glm::vec3(model[2])) };
+
+    ObjectTransform transform{};
+    transform.model = model;
+    transform.boundsMin = glm::vec4(moved.min, std::min({ scale.x, scale.y, scale.z }));
+    transform.boundsMax = glm::vec4(moved.max, std::max({ scale.x, scale.y, scale.z }));
+    return transform;
+}
 
-    throw std::runtime_error("failed to find suitable memory type!");
+ObjectTransform ObjectTransform::interpolate(const Aabb& bounds, const ObjectTransform& from, const ObjectTransform& to,
+                                             float alpha)
+{
+    // A mirrored basis keeps its mirror in the x scale, so what is left is a rotation
+    auto split = [](const glm::mat4& model, glm::vec3& scale, glm::quat& rotation) {
+        glm::mat3 basis(model);
+        scale = glm::max(glm::vec3(glm::length(basis[0]), glm::length(basis[1]), glm::length(basis[2])),
+                         glm::vec3(1e-8f));
+        if (glm::determinant(basis) < 0.0f)
+            scale.x = -scale.x;
+        rotation = glm::quat_cast(glm::mat3(basis[0] / scale.x, basis[1] / scale.y, basis[2] / scale.z));
+    };
+    glm::vec3 fromScale, toScale;
+    glm::quat fromRotation, toRotation;
+    split(from.model, fromScale, fromRotation);
+    split(to.model, toScale, toRotation);
+
+    glm::mat4 model = glm::mat4_cast(glm::slerp(fromRotation, toRotation, alpha));
+    glm::vec3 scale = glm::mix(fromScale, toScale, alpha);
+    for (int axis = 0; axis < 3; ++axis)
+        model[axis] *= scale[axis];
+    model[3] = glm::mix(from.model[3], to.model[3], alpha);
+    return of(bounds, model);
+}
+
+void GNVEngine::uploadObjectTransforms()
+{
+    // One copy for every object, then this frame's sets are pointed at it. The frame's fence has signaled, so neither
+    // set is in use.
+    frameAllocator.beginFrame(frameIndex);
+    vk::DeviceSize bytes = sizeof(ObjectTransform) * objectTransforms.size();
+    FrameAllocator::Allocation allocation = frameAllocator.allocate(std::max<vk::DeviceSize>(bytes, 1));
+    memcpy(allocation.data, objectTransforms.data(), bytes);
+
+    vk::DescriptorBufferInfo transformInfo{};
+    transformInfo.setBuffer(frameAllocator.getBuffer()).setOffset(allocation.offset).setRange(allocation.size);
+    std::array<vk::WriteDescriptorSet, 2> writes{};
+    writes[0]
+        .setDstSet(*descriptorSets[frameIndex])
+        .setDstBinding(2)
+        .setDescriptorCount(1)
+        .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+        .setPBufferInfo(&transformInfo);
+    writes[1] = writes[0];
+    writes[1].setDstSet(*cullDescriptorSets[frameIndex]).setDstBinding(8);
+    device.updateDescriptorSets(writes, {});
+}
+
+void GNVEngine::buildInstanceGroups()
+{
+    // Sorted by what recordMeshDraws() binds and then by mesh and LOD, so each group's instances are one run and
+    // groups that share a pipeline and buffers are next to each other
+    std::ranges::sort(visibleObjects, {}, [&](uint32_t object) {
+        const Mesh& mesh = meshManager[objectMeshes[object]];
+        return std::tuple(mesh.vertexFormat, mesh.geometry.page, mesh.indexType, mesh.doubleSided,
+                          objectMeshes[object], objectLods[object]);
+    });
+
+    instanceGroups.clear();
+    vk::DeviceSize bytes = sizeof(uint32_t) * visibleObjects.size();
+    FrameAllocator::Allocation allocation = frameAllocator.allocate(std::max<vk::DeviceSize>(bytes, 1));
+    memcpy(allocation.data, visibleObjects.data(), bytes);
+    instanceOffset = allocation.offset;
+    for (uint32_t i = 0; i < visibleObjects.size(); ++i) {
+        uint32_t object = visibleObjects[i];
+        if (instanceGroups.empty() || instanceGroups.back().mesh != objectMeshes[object] ||
+            instanceGroups.back().lod != objectLods[object]) {
+            instanceGroups.push_back(InstanceGroup{ objectMeshes[object], objectLods[object], i, 0 });
+        }
+        instanceGroups.back().instanceCount++;
+    }
+}
+
+void GNVEngine::buildSceneBvh()
+{
+    std::vector<Aabb> bounds;
+    bounds.reserve(objectTransforms.size());
+    for (const auto& transform : objectTransforms)
+        bounds.push_back(transform.getBounds());
+    sceneBvh.build(bounds);
+    EngineLog::logger->trace("Scene BVH: {} nodes over {} objects", sceneBvh.getNodeCount(),
+                             sceneBvh.getObjectCount());
+}
+
+void GNVEngine::recordCulling(const vk::raii::CommandBuffer& commandBuffer)
+{
+    commandBuffer.fillBuffer(*drawCountBuffers[frameIndex], 0, VK_WHOLE_SIZE, 0);
+    // The object pass counts cluster workgroups into x
+    commandBuffer.updateBuffer<vk::DispatchIndirectCommand>(*clusterDispatchBuffers[frameIndex], 0,
+                                                            vk::DispatchIndirectCommand(0, 1, 1));
+
+    // Also orders this frame's LOD state updates after the previous frame's
+    vk::MemoryBarrier2 clearBarrier{};
+    clearBarrier
+        .setSrcStageMask(vk::PipelineStageFlagBits2::eAllTransfer | vk::PipelineStageFlagBits2::eComputeShader)
+        .setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite | vk::AccessFlagBits2::eShaderStorageWrite)
+        .setDstStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+        .setDstAccessMask(vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite);
+    vk::DependencyInfo clearDependency{};
+    clearDependency.setMemoryBarrierCount(1).setPMemoryBarriers(&clearBarrier);
+    commandBuffer.pipelineBarrier2(clearDependency);
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *cullPipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *cullPipelineLayout, 0,
+                                     *cullDescriptorSets[frameIndex], nullptr);
+
+    // Planes in object space, so the shader can test the bounds as they are
+    Frustum frustum = Frustum::fromMatrix(ubo.proj * ubo.view * ubo.model);
+    CullPushConstants push{};
+    std::ranges::copy(frustum.planes, push.planes);
+    push.cameraPosition = glm::inverse(ubo.view * ubo.model) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    push.objectCount = objectCount;
+    push.bucketCount = static_cast<uint32_t>(drawBuckets.size());
+    push.lodErrorScale = getLodErrorScale(ubo.proj, static_cast<float>(swapChainExtent.height));
+    push.lodThreshold = settings.lodThreshold;
+    commandBuffer.pushConstants<CullPushConstants>(*cullPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, push);
+    commandBuffer.dispatch((objectCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+
+    vk::MemoryBarrier2 clusterBarrier{};
+    clusterBarrier.setSrcStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+        .setSrcAccessMask(vk::AccessFlagBits2::eShaderStorageWrite)
+        .setDstStageMask(vk::PipelineStageFlagBits2::eDrawIndirect | vk::PipelineStageFlagBits2::eComputeShader)
+        .setDstAccessMask(vk::AccessFlagBits2::eIndirectCommandRead | vk::AccessFlagBits2::eShaderStorageRead |
+                          vk::AccessFlagBits2::eShaderStorageWrite);
+    vk::DependencyInfo clusterDependency{};
+    clusterDependency.setMemoryBarrierCount(1).setPMemoryBarriers(&clusterBarrier);
+    commandBuffer.pipelineBarrier2(clusterDependency);
+
+    // One workgroup per queued object, same descriptor set and push constants
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *clusterCullPipeline);
+    commandBuffer.dispatchIndirect(*clusterDispatchBuffers[frameIndex], 0);
+
+    vk::MemoryBarrier2 drawBarrier{};
+    drawBarrier.setSrcStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+        .setSrcAccessMask(vk::AccessFlagBits2::eShaderStorageWrite)
+        .setDstStageMask(vk::PipelineStageFlagBits2::eDrawIndirect | vk::PipelineStageFlagBits2::eHost)
+        .setDstAccessMask(vk::AccessFlagBits2::eIndirectCommandRead | vk::AccessFlagBits2::eHostRead);
+    vk::DependencyInfo drawDependency{};
+    drawDependency.setMemoryBarrierCount(1).setPMemoryBarriers(&drawBarrier);
+    commandBuffer.pipelineBarrier2(drawDependency);
+}
+
+void GNVEngine::createCommandPool()
+{
+    vk::CommandPoolCreateInfo poolInfo{};
+    poolInfo.setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer).setQueueFamilyIndex(queueIndex);
+    commandPool = vk::raii::CommandPool(device, poolInfo);
+}
+
+void GNVEngine::uploadMesh(Mesh& mesh)
+{
+    uint32_t indexStride = mesh.indexType == vk::IndexType::eUint16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    mesh.geometry =
+        geometry.allocate(mesh.vertexCount, getVertexStride(mesh.vertexFormat), mesh.indexCount, indexStride);
+
+    uploads.uploadBuffer(mesh.vertexData.data(), mesh.geometry.vertexSize, geometry.getVertexBuffer(mesh.geometry.page),
+                         mesh.geometry.vertexOffset);
+    mesh.uploadHandle = uploads.uploadBuffer(mesh.indexData.data(), mesh.geometry.indexSize,
+                                             geometry.getIndexBuffer(mesh.geometry.page), mesh.geometry.indexOffset);
+}
+
+void GNVEngine::createAllocator()
+{
+    allocator = GpuAllocator(instance, physicalDevice, device, vk::ApiVersion13);
+}
+
+void GNVEngine::createPipelineCache()
+{
+    pipelineCache = PipelineCache(device, physicalDevice, PIPELINE_CACHE_DIR);
+    EngineLog::logger->info("Pipeline cache {} ({})", pipelineCache.isWarm() ? "loaded" : "created",
+                            pipelineCache.getPath().string());
+}
+
+void GNVEngine::createUploadScheduler()
+{
+    uploads = UploadScheduler(device, queue, queueIndex, *allocator, UPLOAD_RING_SIZE);
+}
+
+void GNVEngine::createGeometryArena()
+{
+    geometry = GeometryArena(*allocator, GEOMETRY_VERTEX_PAGE_SIZE, GEOMETRY_INDEX_PAGE_SIZE, MAX_FRAMES_IN_FLIGHT);
 }
 
 void GNVEngine::createCommandBuffers()
 {
     commandBuffers.clear();
-    vk::CommandBufferAllocateInfo allocInfo{};
-    allocInfo.setCommandPool(commandPool)
-        .setLevel(vk::CommandBufferLevel::ePrimary)
-        .setCommandBufferCount(MAX_FRAMES_IN_FLIGHT);
-    commandBuffers = vk::raii::CommandBuffers(device, allocInfo);
+    framePools.clear();
+
+    // Transient pools, reset as a whole instead of per command buffer
+    vk::CommandPoolCreateInfo poolInfo{};
+    poolInfo.setFlags(vk::CommandPoolCreateFlagBits::eTransient).setQueueFamilyIndex(queueIndex);
+    size_t recorderCount = threadPool.get_thread_count();
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        FrameCommandPools pools{};
+        pools.primary = vk::raii::CommandPool(device, poolInfo);
+        vk::CommandBufferAllocateInfo allocInfo{};
+        allocInfo.setCommandPool(*pools.primary).setLevel(vk::CommandBufferLevel::ePrimary).setCommandBufferCount(1);
+        commandBuffers.push_back(std::move(vk::raii::CommandBuffers(device, allocInfo).front()));
+
+        for (size_t r = 0; r < recorderCount; r++) {
+            pools.workers.emplace_back(device, poolInfo);
+            allocInfo.setCommandPool(*pools.workers.back()).setLevel(vk::CommandBufferLevel::eSecondary);
+            pools.secondaries.push_back(std::move(vk::raii::CommandBuffers(device, allocInfo).front()));
+        }
+        framePools.push_back(std::move(pools));
+    }
+}
+
+void GNVEngine::recordMeshDraws(const vk::raii::CommandBuffer& commandBuffer,
+                                std::span<const InstanceGroup> groups) const
+{
+    commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(swapChainExtent.width),
+                                              static_cast<float>(swapChainExtent.height), 0.0f, 1.0f));
+    commandBuffer.setScissor(
+        0, vk::Rect2D(vk::Offset2D(0, 0), vk::Extent2D{ static_cast<uint32_t>(swapChainExtent.width),
+                                                        static_cast<uint32_t>(swapChainExtent.height) }));
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipelineLayout, 0,
+                                     *descriptorSets[frameIndex], nullptr);
+    commandBuffer.bindVertexBuffers(INSTANCE_BINDING, frameAllocator.getBuffer(), instanceOffset);
+
+    // Every mesh lives in an arena page, so buffers are only rebound when the page or index type changes, and the
+    // pipeline when the vertex format does
+    uint32_t boundPage = UINT32_MAX;
+    std::optional<VertexFormat> boundFormat;
+    std::optional<vk::IndexType> boundIndexType;
+    std::optional<bool> boundDoubleSided;
+    for (const InstanceGroup& group : groups) {
+        const Mesh& mesh = meshManager[group.mesh];
+        if (mesh.vertexFormat != boundFormat) {
+            boundFormat = mesh.vertexFormat;
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics,
+                                       *graphicsPipelines[static_cast<size_t>(mesh.vertexFormat)]);
+        }
+        if (mesh.geometry.page != boundPage) {
+            boundPage = mesh.geometry.page;
+            boundIndexType.reset();
+            commandBuffer.bindVertexBuffers(0, geometry.getVertexBuffer(boundPage), { 0 });
+        }
+        if (mesh.indexType != boundIndexType) {
+            boundIndexType = mesh.indexType;
+            commandBuffer.bindIndexBuffer(geometry.getIndexBuffer(boundPage), 0, mesh.indexType);
+        }
+        if (mesh.doubleSided != boundDoubleSided) {
+            boundDoubleSided = mesh.doubleSided;
+            commandBuffer.setCullMode(mesh.doubleSided ? vk::CullModeFlagBits::eNone : vk::CullModeFlagBits::eBack);
+        }
+        const MeshLod& lod = mesh.lods[group.lod];
+        commandBuffer.drawIndexed(lod.indexCount, group.instanceCount, mesh.geometry.firstIndex + lod.firstIndex,
+                                  mesh.geometry.firstVertex, group.firstInstance);
+    }
+}
+
+void GNVEngine::recordMeshDrawsParallel(const vk::raii::CommandBuffer& commandBuffer, uint32_t recorderCount)
+{
+    FrameCommandPools& pools = framePools[frameIndex];
+
+    // Secondaries don't inherit dynamic state or bindings, only the attachment formats of the rendering instance
+    vk::CommandBufferInheritanceRenderingInfo renderingInheritance{};
+    renderingInheritance.setColorAttachmentCount(1)
+        .setPColorAttachmentFormats(&swapChainSurfaceFormat.format)
+        .setDepthAttachmentFormat(depthFormat)
+        .setRasterizationSamples(vk::SampleCountFlagBits::e1);
+    vk::CommandBufferInheritanceInfo inheritance{};
+    inheritance.setPNext(&renderingInheritance);
+
+    size_t drawsPerRecorder = (instanceGroups.size() + recorderCount - 1) / recorderCount;
+    BS::multi_future<void> tasks = threadPool.submit_loop<uint32_t>(
+        0, recorderCount,
+        [&](uint32_t r) {
+            const vk::raii::CommandBuffer& secondary = pools.secondaries[r];
+            vk::CommandBufferBeginInfo beginInfo{};
+            beginInfo
+                .setFlags(vk::CommandBufferUsageFlagBits::eRenderPassContinue |
+                          vk::CommandBufferUsageFlagBits::eOneTimeSubmit)
+                .setPInheritanceInfo(&inheritance);
+            secondary.begin(beginInfo);
+            size_t first = r * drawsPerRecorder;
+            size_t count = std::min(drawsPerRecorder, instanceGroups.size() - std::min(first, instanceGroups.size()));
+            recordMeshDraws(secondary, std::span(instanceGroups).subspan(first, count));
+            secondary.end();
+        },
+        recorderCount);
+    tasks.wait();
+    tasks.get();
+
+    std::vector<vk::CommandBuffer> secondaries;
+    for (uint32_t r = 0; r < recorderCount; r++)
+        secondaries.push_back(*pools.secondaries[r]);
+    commandBuffer.executeCommands(secondaries);
 }
 
 void GNVEngine::recordCommandBuffer(uint32_t imageIndex)
 {
     auto& commandBuffer = commandBuffers[frameIndex];
+    vk::Image colorImage = settings.headless ? *offscreenImages[imageIndex] : swapChainImages[imageIndex];
+    vk::ImageView colorImageView =
+        settings.headless ? *offscreenImageViews[imageIndex] : *swapChainImageViews[imageIndex];
+
     commandBuffer.begin({});
+    if (*timestampQueryPool) {
+        commandBuffer.resetQueryPool(*timestampQueryPool, frameIndex * 2, 2);
+        commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eTopOfPipe, *timestampQueryPool, frameIndex * 2);
+    }
+    if (settings.gpuCulling && objectCount > 0)
+        recordCulling(commandBuffer);
     // Before starting rendering, transition the swapchain image to COLOR_ATTACHMENT_OPTIMAL
     transition_image_layout(
-        swapChainImages[imageIndex], vk::ImageLayout::eUndefined, vk::ImageLayout::eColorAttachmentOptimal,
+        colorImage, vk::ImageLayout::eUndefined, vk::ImageLayout::eColorAttachmentOptimal,
         {}, // srcAccessMask (no need to wait for previous operations)
         vk::AccessFlagBits2::eColorAttachmentWrite, vk::PipelineStageFlagBits2::eColorAttachmentOutput,
         vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::ImageAspectFlagBits::eColor);
@@ -594,7 +1533,7 @@ void GNVEngine::recordCommandBuffer(uint32_t imageIndex)
 
     vk::ClearValue clearColor = vk::ClearColorValue(0.2f, 0.2f, 0.2f, 1.0f);
     vk::RenderingAttachmentInfo attachmentInfo{};
-    attachmentInfo.setImageView(swapChainImageViews[imageIndex])
+    attachmentInfo.setImageView(colorImageView)
         .setImageLayout(vk::ImageLayout::eColorAttachmentOptimal)
         .setLoadOp(vk::AttachmentLoadOp::eClear)
         .setStoreOp(vk::AttachmentStoreOp::eStore)
@@ -617,28 +1556,63 @@ void GNVEngine::recordCommandBuffer(uint32_t imageIndex)
         .setPColorAttachments(&attachmentInfo)
         .setPDepthAttachment(&depthAttachmentInfo);
 
-    commandBuffer.beginRendering(renderingInfo);
-    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *graphicsPipeline);
-    commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(swapChainExtent.width),
-                                              static_cast<float>(swapChainExtent.height), 0.0f, 1.0f));
-    commandBuffer.setScissor(
-        0, vk::Rect2D(vk::Offset2D(0, 0), vk::Extent2D{ static_cast<uint32_t>(swapChainExtent.width),
-                                                        static_cast<uint32_t>(swapChainExtent.height) }));
-    for (auto& mesh : meshManager) {
-        commandBuffer.bindVertexBuffers(0, *mesh.vertexBuffer, { 0 });
-        // commandBuffer.bindIndexBuffer(*mesh.indexBuffer, 0,
-        //                               vk::IndexTypeValue<decltype(mesh.indices)::value_type>::value);
-        commandBuffer.bindIndexBuffer(*mesh.indexBuffer, 0, vk::IndexType::eUint32);
+    lastRecorderCount = 1;
+    if (!settings.gpuCulling) {
+        lastRecorderCount = static_cast<uint32_t>(std::clamp<size_t>(instanceGroups.size() / MIN_DRAWS_PER_RECORDER,
+                                                                     1, framePools[frameIndex].secondaries.size()));
+    }
+
+    if (lastRecorderCount > 1) {
+        // The whole rendering instance has to come from secondaries once one of them is executed in it
+        renderingInfo.setFlags(vk::RenderingFlagBits::eContentsSecondaryCommandBuffers);
+        commandBuffer.beginRendering(renderingInfo);
+        recordMeshDrawsParallel(commandBuffer, lastRecorderCount);
+    } else if (settings.gpuCulling) {
+        commandBuffer.beginRendering(renderingInfo);
+        commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(swapChainExtent.width),
+                                                  static_cast<float>(swapChainExtent.height), 0.0f, 1.0f));
+        commandBuffer.setScissor(
+            0, vk::Rect2D(vk::Offset2D(0, 0), vk::Extent2D{ static_cast<uint32_t>(swapChainExtent.width),
+                                                            static_cast<uint32_t>(swapChainExtent.height) }));
         commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipelineLayout, 0,
                                          *descriptorSets[frameIndex], nullptr);
-        commandBuffer.pushConstants<uint32_t>(*pipelineLayout, vk::ShaderStageFlagBits::eFragment, 0,
-                                              mesh.textureIndex);
-        commandBuffer.drawIndexed(mesh.indices.size(), 1, 0, 0, 0);
+        commandBuffer.bindVertexBuffers(INSTANCE_BINDING, *objectIndexBuffer, { 0 });
+        // One indirect draw per bucket, the cull pass decided how many of its commands are live
+        for (uint32_t b = 0; b < drawBuckets.size(); ++b) {
+            const DrawBucket& bucket = drawBuckets[b];
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics,
+                                       *graphicsPipelines[static_cast<size_t>(bucket.format)]);
+            commandBuffer.bindVertexBuffers(0, geometry.getVertexBuffer(bucket.page), { 0 });
+            commandBuffer.bindIndexBuffer(geometry.getIndexBuffer(bucket.page), 0, bucket.indexType);
+            commandBuffer.setCullMode(bucket.doubleSided ? vk::CullModeFlagBits::eNone
+                                                         : vk::CullModeFlagBits::eBack);
+            commandBuffer.drawIndexedIndirectCount(
+                *drawCommandBuffers[frameIndex], bucket.commandBase * sizeof(vk::DrawIndexedIndirectCommand),
+                *drawCountBuffers[frameIndex], b * sizeof(uint32_t), bucket.capacity,
+                sizeof(vk::DrawIndexedIndirectCommand));
+        }
+    } else {
+        commandBuffer.beginRendering(renderingInfo);
+        recordMeshDraws(commandBuffer, instanceGroups);
     }
     commandBuffer.endRendering();
 
+    if (settings.headless) {
+        // Leave the offscreen image readable for captures
+        transition_image_layout(colorImage, vk::ImageLayout::eColorAttachmentOptimal,
+                                vk::ImageLayout::eTransferSrcOptimal, vk::AccessFlagBits2::eColorAttachmentWrite,
+                                vk::AccessFlagBits2::eTransferRead, vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+                                vk::PipelineStageFlagBits2::eTransfer, vk::ImageAspectFlagBits::eColor);
+        if (*timestampQueryPool) {
+            commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eBottomOfPipe, *timestampQueryPool,
+                                          frameIndex * 2 + 1);
+        }
+        commandBuffer.end();
+        return;
+    }
+
     vk::RenderingAttachmentInfo imGuiAttachmentInfo{};
-    imGuiAttachmentInfo.setImageView(swapChainImageViews[imageIndex])
+    imGuiAttachmentInfo.setImageView(colorImageView)
         .setImageLayout(vk::ImageLayout::eColorAttachmentOptimal)
         .setLoadOp(vk::AttachmentLoadOp::eLoad)
         .setStoreOp(vk::AttachmentStoreOp::eStore);
@@ -655,10 +1629,14 @@ void GNVEngine::recordCommandBuffer(uint32_t imageIndex)
     commandBuffer.endRendering();
 
     // After rendering, transition the swapchain image to PRESENT_SRC
-    transition_image_layout(swapChainImages[imageIndex], vk::ImageLayout::eColorAttachmentOptimal,
-                            vk::ImageLayout::ePresentSrcKHR, vk::AccessFlagBits2::eColorAttachmentWrite, {},
+    transition_image_layout(colorImage, vk::ImageLayout::eColorAttachmentOptimal, vk::ImageLayout::ePresentSrcKHR,
+                            vk::AccessFlagBits2::eColorAttachmentWrite, {},
                             vk::PipelineStageFlagBits2::eColorAttachmentOutput,
                             vk::PipelineStageFlagBits2::eBottomOfPipe, vk::ImageAspectFlagBits::eColor);
+    if (*timestampQueryPool) {
+        commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eBottomOfPipe, *timestampQueryPool,
+                                      frameIndex * 2 + 1);
+    }
     commandBuffer.end();
 }
 
@@ -705,37 +1683,76 @@ void GNVEngine::createSyncObjects()
 
 void GNVEngine::drawFrame()
 {
+    auto frameStart = std::chrono::high_resolution_clock::now();
+    if (textureDefragmentRequested) {
+        textureDefragmentRequested = false;
+        defragmentTextures();
+    }
+
     // Note: inFlightFences, presentCompleteSemaphores, and commandBuffers are indexed by frameIndex,
     //       while renderFinishedSemaphores is indexed by imageIndex
     while (vk::Result::eTimeout == device.waitForFences(*inFlightFences[frameIndex], vk::True, UINT64_MAX))
         ;
     device.resetFences(*inFlightFences[frameIndex]);
+    resolveFrameTiming(frameIndex);
+    geometry.nextFrame();
+    if (settings.gpuCulling && !drawCountBuffers.empty()) {
+        auto& counts = drawCountBuffers[frameIndex];
+        counts.invalidate();
+        auto* bucketCounts = static_cast<const uint32_t*>(counts.getMapped());
+        drawCount = std::accumulate(bucketCounts, bucketCounts + drawBuckets.size(), 0u);
+        drawnTriangles = bucketCounts[drawBuckets.size()];
+        visibleCount = bucketCounts[drawBuckets.size() + 1];
+    } else {
+        visibleCount = cpuCullStats.visible;
+        drawCount = static_cast<uint32_t>(instanceGroups.size());
+    }
 
-    auto [result, imageIndex] = swapChain.acquireNextImage(UINT64_MAX, *presentCompleteSemaphores[frameIndex], nullptr);
+    // Headless targets are owned per frame in flight, so there is nothing to acquire
+    uint32_t imageIndex = frameIndex;
+    if (!settings.headless) {
+        auto [result, acquiredIndex] =
+            swapChain.acquireNextImage(UINT64_MAX, *presentCompleteSemaphores[frameIndex], nullptr);
 
-    if (result == vk::Result::eErrorOutOfDateKHR) {
-        recreateSwapChain();
-        return;
-    }
-    if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR) {
-        throw std::runtime_error("failed to acquire swap chain image!");
+        if (result == vk::Result::eErrorOutOfDateKHR) {
+            recreateSwapChain();
+            return;
+        }
+        if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR) {
+            throw std::runtime_error("failed to acquire swap chain image!");
+        }
+        imageIndex = acquiredIndex;
     }
-    updateUniformBuffer(frameIndex);
 
-    commandBuffers[frameIndex].reset();
-    newImGuiFrame();
-    recordCommandBuffer(imageIndex);
+    auto cpuStart = std::chrono::high_resolution_clock::now();
+    frameImageIndex = imageIndex;
+    frameGraph.run();
 
     vk::PipelineStageFlags waitDestinationStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput);
     vk::SubmitInfo submitInfo{};
-    submitInfo.setWaitSemaphoreCount(1)
-        .setPWaitSemaphores(&*presentCompleteSemaphores[frameIndex])
-        .setPWaitDstStageMask(&waitDestinationStageMask)
-        .setCommandBufferCount(1)
-        .setPCommandBuffers(&*commandBuffers[frameIndex])
-        .setSignalSemaphoreCount(1)
-        .setPSignalSemaphores(&*renderFinishedSemaphores[imageIndex]);
+    submitInfo.setCommandBufferCount(1).setPCommandBuffers(&*commandBuffers[frameIndex]);
+    if (!settings.headless) {
+        submitInfo.setWaitSemaphoreCount(1)
+            .setPWaitSemaphores(&*presentCompleteSemaphores[frameIndex])
+            .setPWaitDstStageMask(&waitDestinationStageMask)
+            .setSignalSemaphoreCount(1)
+            .setPSignalSemaphores(&*renderFinishedSemaphores[imageIndex]);
+    }
     queue.submit(submitInfo, *inFlightFences[frameIndex]);
+    auto cpuEnd = std::chrono::high_resolution_clock::now();
+
+    if (settings.headless || settings.benchmarkFrames > 0) {
+        // GPU time for this slot is only known once its fence signals, see resolveFrameTiming()
+        pendingTimings[frameIndex] = PendingFrameTiming{
+            true, benchmarkFrame, std::chrono::duration<double, std::milli>(cpuEnd - frameStart).count(),
+            std::chrono::duration<double, std::milli>(cpuEnd - cpuStart).count()
+        };
+    }
+
+    if (settings.headless) {
+        frameIndex = (frameIndex + 1) % MAX_FRAMES_IN_FLIGHT;
+        return;
+    }
 
     try {
         vk::PresentInfoKHR presentInfoKHR{};
@@ -744,7 +1761,7 @@ void GNVEngine::drawFrame()
             .setSwapchainCount(1)
             .setPSwapchains(&*swapChain)
             .setPImageIndices(&imageIndex);
-        result = queue.presentKHR(presentInfoKHR);
+        vk::Result result = queue.presentKHR(presentInfoKHR);
         if (result == vk::Result::eErrorOutOfDateKHR || result == vk::Result::eSuboptimalKHR || framebufferResized) {
             framebufferResized = false;
             recreateSwapChain();
@@ -762,6 +1779,88 @@ void GNVEngine::drawFrame()
     frameIndex = (frameIndex + 1) % MAX_FRAMES_IN_FLIGHT;
 }
 
+void GNVEngine::createTimestampQueryPool()
+{
+    auto queueFamilyProperties = physicalDevice.getQueueFamilyProperties();
+    if (queueFamilyProperties[queueIndex].timestampValidBits == 0) {
+        EngineLog::logger->warn("Queue family {} has no timestamp support, GPU timings disabled", queueIndex);
+        return;
+    }
+    timestampPeriod = physicalDevice.getProperties().limits.timestampPeriod;
+
+    // Two queries (begin, end) per frame in flight
+    vk::QueryPoolCreateInfo poolInfo{};
+    poolInfo.setQueryType(vk::QueryType::eTimestamp).setQueryCount(2 * MAX_FRAMES_IN_FLIGHT);
+    timestampQueryPool = vk::raii::QueryPool(device, poolInfo);
+}
+
+void GNVEngine::resolveFrameTiming(uint32_t slot)
+{
+    auto& pending = pendingTimings[slot];
+    if (!pending.valid)
+        return;
+    pending.valid = false;
+
+    FrameTiming timing{ pending.frame, pending.frameMs, pending.cpuMs, std::nullopt };
+    if (*timestampQueryPool) {
+        auto [result, ticks] = timestampQueryPool.getResults<uint64_t>(
+            slot * 2, 2, 2 * sizeof(uint64_t), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+        if (result == vk::Result::eSuccess) {
+            timing.gpuMs = static_cast<double>(ticks[1] - ticks[0]) * timestampPeriod / 1.0e6;
+        }
+    }
+    benchmark.record(timing);
+}
+
+void GNVEngine::applyCameraPath(uint32_t frame, uint32_t frameCount)
+{
+    if (settings.cameraPath != CameraPath::Orbit || frameCount == 0)
+        return;
+
+    // One full revolution around the target over the run, keeping the starting radius and height
+    glm::vec3 offset = cameraPathOrigin - camera.target;
+    float angle = glm::radians(360.0f) * static_cast<float>(frame) / static_cast<float>(frameCount);
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+    camera.position = camera.target + glm::vec3(offset.x * c - offset.z * s, offset.y, offset.x * s + offset.z * c);
+}
+
+void GNVEngine::runBenchmark()
+{
+    uint32_t frameCount = settings.benchmarkFrames;
+    EngineLog::logger->info("Benchmark: {} frames, {}", frameCount, settings.headless ? "headless" : "windowed");
+    benchmark.reset(frameCount);
+    cameraPathOrigin = camera.position;
+
+    for (benchmarkFrame = 0; benchmarkFrame < frameCount; benchmarkFrame++) {
+        if (!settings.headless) {
+            glfwPollEvents();
+            if (glfwWindowShouldClose(window))
+                break;
+        }
+        applyCameraPath(benchmarkFrame, frameCount);
+        drawFrame();
+    }
+    device.waitIdle();
+
+    // Resolve the frames still in flight oldest first so the report stays in frame order
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        resolveFrameTiming((frameIndex + i) % MAX_FRAMES_IN_FLIGHT);
+    }
+
+    auto cpu = benchmark.summarizeCpu();
+    EngineLog::logger->info("CPU ms avg:{:.3f} p50:{:.3f} p95:{:.3f} p99:{:.3f} max:{:.3f}", cpu.avg, cpu.p50,
+                            cpu.p95, cpu.p99, cpu.max);
+    if (auto gpu = benchmark.summarizeGpu()) {
+        EngineLog::logger->info("GPU ms avg:{:.3f} p50:{:.3f} p95:{:.3f} p99:{:.3f} max:{:.3f}", gpu->avg, gpu->p50,
+                                gpu->p95, gpu->p99, gpu->max);
+    }
+
+    std::string deviceName = physicalDevice.getProperties().deviceName.data();
+    benchmark.writeReport(settings.reportPath, deviceName);
+    EngineLog::logger->info("Benchmark report written to {}", settings.reportPath);
+}
+
 [[nodiscard]] vk::raii::ShaderModule GNVEngine::createShaderModule(const std::vector<char>& code) const
 {
     vk::ShaderModuleCreateInfo createInfo{};
@@ -782,12 +1881,17 @@ uint32_t GNVEngine::chooseSwapMinImageCount(vk::SurfaceCapabilitiesKHR const& su
 
 vk::SurfaceFormatKHR GNVEngine::chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& availableFormats)
 {
-    // used to be vk::Format::eB8G8R8A8Srgb, changed to Unorm to match ImGui
+    // used to be vk::Format::eB8G8R8A8Srgb, changed to Unorm to match ImGui. The fragment shader encodes to sRGB
+    // itself, so any other format would encode twice or not at all.
     assert(!availableFormats.empty());
-    const auto formatIt = std::ranges::find_if(availableFormats, [](const auto& format) {
-        return format.format == vk::Format::eB8G8R8A8Unorm && format.colorSpace == vk::ColorSpaceKHR::eSrgbNonlinear;
-    });
-    return formatIt != availableFormats.end() ? *formatIt : availableFormats[0];
+    for (vk::Format wanted : { vk::Format::eB8G8R8A8Unorm, vk::Format::eR8G8B8A8Unorm }) {
+        const auto formatIt = std::ranges::find_if(availableFormats, [wanted](const auto& format) {
+            return format.format == wanted && format.colorSpace == vk::ColorSpaceKHR::eSrgbNonlinear;
+        });
+        if (formatIt != availableFormats.end())
+            return *formatIt;
+    }
+    throw std::runtime_error("surface has no 8-bit UNORM format in the sRGB color space!");
 }
 
 vk::PresentModeKHR GNVEngine::chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& availablePresentModes)
@@ -814,10 +1918,12 @@ vk::Extent2D GNVEngine::chooseSwapExtent(const vk::SurfaceCapabilitiesKHR& capab
 
 std::vector<const char*> GNVEngine::getRequiredExtensions()
 {
-    uint32_t glfwExtensionCount = 0;
-    auto glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-    std::vector extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    std::vector<const char*> extensions;
+    if (!settings.headless) {
+        uint32_t glfwExtensionCount = 0;
+        auto glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
     if (enableValidationLayers) {
         extensions.push_back(vk::EXTDebugUtilsExtensionName);
     }
@@ -852,49 +1958,34 @@ std::vector<char> GNVEngine::readFile(const std::string& filename)
     return buffer;
 }
 
-void GNVEngine::createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties,
-                             vk::raii::Buffer& buffer, vk::raii::DeviceMemory& bufferMemory)
+void GNVEngine::createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, VmaAllocationCreateFlags allocationFlags,
+                             GpuBuffer& buffer)
 {
     vk::BufferCreateInfo bufferInfo{};
     bufferInfo.setSize(size).setUsage(usage).setSharingMode(vk::SharingMode::eExclusive);
-    buffer = vk::raii::Buffer(device, bufferInfo);
 
-    vk::MemoryRequirements memRequirements = buffer.getMemoryRequirements();
-    vk::MemoryAllocateInfo allocInfo{};
-    allocInfo.setAllocationSize(memRequirements.size)
-        .setMemoryTypeIndex(findMemoryType(memRequirements.memoryTypeBits, properties));
-    bufferMemory = vk::raii::DeviceMemory(device, allocInfo);
-    buffer.bindMemory(*bufferMemory, 0);
-}
-
-void GNVEngine::copyBuffer(vk::raii::Buffer& srcBuffer, vk::raii::Buffer& dstBuffer, vk::DeviceSize size)
-{
-    vk::CommandBufferAllocateInfo allocInfo{};
-    allocInfo.setCommandPool(commandPool).setLevel(vk::CommandBufferLevel::ePrimary).setCommandBufferCount(1);
-    vk::raii::CommandBuffer commandCopyBuffer = std::move(device.allocateCommandBuffers(allocInfo).front());
-
-    vk::CommandBufferBeginInfo beginInfo{};
-    beginInfo.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
-
-    commandCopyBuffer.begin(beginInfo);
-    commandCopyBuffer.copyBuffer(*srcBuffer, *dstBuffer, vk::BufferCopy(0, 0, size));
-    commandCopyBuffer.end();
-
-    vk::SubmitInfo submitInfo{};
-    submitInfo.setCommandBufferCount(1).setPCommandBuffers(&*commandCopyBuffer);
-    queue.submit(submitInfo, nullptr);
-
-    queue.waitIdle();
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_AUTO;
+    allocInfo.flags = allocationFlags;
+    buffer = GpuBuffer(*allocator, bufferInfo, allocInfo);
 }
 
 void GNVEngine::createDescriptorSetLayout()
 {
+    // The variable-count texture array has to stay the highest binding
     std::array bindings = { vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eUniformBuffer, 1,
                                                            vk::ShaderStageFlagBits::eVertex, nullptr),
-                            vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eCombinedImageSampler, MAX_TEXTURES,
+                            vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eStorageBuffer, 1,
+                                                           vk::ShaderStageFlagBits::eVertex, nullptr),
+                            vk::DescriptorSetLayoutBinding(2, vk::DescriptorType::eStorageBuffer, 1,
+                                                           vk::ShaderStageFlagBits::eVertex, nullptr),
+                            vk::DescriptorSetLayoutBinding(3, vk::DescriptorType::eCombinedImageSampler,
+                                                           bindlessTextures.getCapacity(),
                                                            vk::ShaderStageFlagBits::eFragment, nullptr) };
 
-    std::array<vk::DescriptorBindingFlags, 2> bindingFlags = {
+    std::array<vk::DescriptorBindingFlags, 4> bindingFlags = {
+        vk::DescriptorBindingFlags{},
+        vk::DescriptorBindingFlags{},
         vk::DescriptorBindingFlags{},
         vk::DescriptorBindingFlagBits::eVariableDescriptorCount | vk::DescriptorBindingFlagBits::ePartiallyBound |
             vk::DescriptorBindingFlagBits::eUpdateAfterBind | vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending
@@ -917,9 +2008,8 @@ void GNVEngine::createDepthResources()
     EngineLog::logger->debug("Depth format {}", vk::to_string(depthFormat));
 
     createImage(swapChainExtent.width, swapChainExtent.height, 1, depthFormat, vk::ImageTiling::eOptimal,
-                vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal, depthImage,
-                depthImageMemory);
-    depthImageView = createImageView(depthImage, depthFormat, vk::ImageAspectFlagBits::eDepth, 1);
+                vk::ImageUsageFlagBits::eDepthStencilAttachment, depthImage);
+    depthImageView = createImageView(*depthImage, depthFormat, vk::ImageAspectFlagBits::eDepth, 1);
 }
 
 vk::Format GNVEngine::findSupportedFormat(const std::vector<vk::Format>& candidates, vk::ImageTiling tiling,
@@ -949,8 +2039,7 @@ void GNVEngine::findDepthFormat()
 }
 
 void GNVEngine::createImage(uint32_t width, uint32_t height, uint32_t mipLevels, vk::Format format,
-                            vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties,
-                            vk::raii::Image& image, vk::raii::DeviceMemory& imageMemory)
+                            vk::ImageTiling tiling, vk::ImageUsageFlags usage, GpuImage& image)
 {
     vk::ImageCreateInfo imageInfo{};
     imageInfo.setImageType(vk::ImageType::e2D)
@@ -963,86 +2052,198 @@ void GNVEngine::createImage(uint32_t width, uint32_t height, uint32_t mipLevels,
         .setUsage(usage)
         .setSharingMode(vk::SharingMode::eExclusive)
         .setInitialLayout(vk::ImageLayout::eUndefined);
-    image = vk::raii::Image(device, imageInfo);
 
-    vk::MemoryRequirements memRequirements = image.getMemoryRequirements();
-    vk::MemoryAllocateInfo allocInfo{};
-    allocInfo.setAllocationSize(memRequirements.size)
-        .setMemoryTypeIndex(findMemoryType(memRequirements.memoryTypeBits, properties));
-    imageMemory = vk::raii::DeviceMemory(device, allocInfo);
-    image.bindMemory(*imageMemory, 0);
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+
+    // Render targets are recreated on resize and large textures would waste most of a shared block,
+    // so both get a dedicated allocation; everything else is sub-allocated
+    vk::DeviceImageMemoryRequirements imageRequirements{};
+    imageRequirements.setPCreateInfo(&imageInfo);
+    vk::DeviceSize imageSize = device.getImageMemoryRequirements(imageRequirements).memoryRequirements.size;
+    if ((usage & (vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment)) ||
+        imageSize >= DEDICATED_IMAGE_THRESHOLD) {
+        allocInfo.flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+    }
+    image = GpuImage(*allocator, imageInfo, allocInfo);
 }
 
-vk::raii::ImageView GNVEngine::createImageView(vk::raii::Image& image, vk::Format format,
+vk::raii::ImageView GNVEngine::createImageView(vk::Image image, vk::Format format,
                                                vk::ImageAspectFlags aspectFlags, uint32_t mipLevels)
 {
     vk::ImageSubresourceRange range{};
     range.setAspectMask(vk::ImageAspectFlagBits::eColor).setBaseMipLevel(0).setLevelCount(mipLevels).setLayerCount(1);
 
     vk::ImageViewCreateInfo viewInfo{};
-    viewInfo.setImage(*image).setViewType(vk::ImageViewType::e2D).setFormat(format).setSubresourceRange(range);
+    viewInfo.setImage(image).setViewType(vk::ImageViewType::e2D).setFormat(format).setSubresourceRange(range);
     return vk::raii::ImageView(device, viewInfo);
 }
 
-size_t GNVEngine::createTexture(const uint8_t* ktxData, size_t ktxSize)
+void GNVEngine::chooseTranscodeTargets()
+{
+    // In order of preference. RGBA32 is always supported, so it goes last and findSupportedFormat() can't throw. The
+    // sRGB formats come with the same device features as their unorm ones.
+    const std::array<TranscodeTarget, 5> opaque = { {
+        { KTX_TTF_BC7_RGBA, vk::Format::eBc7UnormBlock, vk::Format::eBc7SrgbBlock },
+        { KTX_TTF_BC1_RGB, vk::Format::eBc1RgbUnormBlock, vk::Format::eBc1RgbSrgbBlock },
+        { KTX_TTF_ASTC_4x4_RGBA, vk::Format::eAstc4x4UnormBlock, vk::Format::eAstc4x4SrgbBlock },
+        // ETC1 blocks are valid ETC2 blocks
+        { KTX_TTF_ETC1_RGB, vk::Format::eEtc2R8G8B8UnormBlock, vk::Format::eEtc2R8G8B8SrgbBlock },
+        {},
+    } };
+    const std::array<TranscodeTarget, 5> alpha = { {
+        { KTX_TTF_BC7_RGBA, vk::Format::eBc7UnormBlock, vk::Format::eBc7SrgbBlock },
+        { KTX_TTF_BC3_RGBA, vk::Format::eBc3UnormBlock, vk::Format::eBc3SrgbBlock },
+        { KTX_TTF_ASTC_4x4_RGBA, vk::Format::eAstc4x4UnormBlock, vk::Format::eAstc4x4SrgbBlock },
+        { KTX_TTF_ETC2_RGBA, vk::Format::eEtc2R8G8B8A8UnormBlock, vk::Format::eEtc2R8G8B8A8SrgbBlock },
+        {},
+    } };
+
+    auto choose = [&](std::span<const TranscodeTarget> candidates) {
+        std::vector<vk::Format> formats;
+        for (const auto& candidate : candidates)
+            formats.push_back(candidate.unorm);
+        vk::Format format = findSupportedFormat(formats, vk::ImageTiling::eOptimal,
+                                                vk::FormatFeatureFlagBits::eSampledImage |
+                                                    vk::FormatFeatureFlagBits::eSampledImageFilterLinear |
+                                                    vk::FormatFeatureFlagBits::eTransferDst);
+        return *std::ranges::find(candidates, format, &TranscodeTarget::unorm);
+    };
+    transcodeTargets.opaque = choose(opaque);
+    transcodeTargets.alpha = choose(alpha);
+    EngineLog::logger->info("Basis textures transcode to {} (opaque) and {} (alpha)",
+                            vk::to_string(transcodeTargets.opaque.unorm), vk::to_string(transcodeTargets.alpha.unorm));
+}
+
+DecodedTexture GNVEngine::decodeTexture(const uint8_t* ktxData, size_t ktxSize, const TranscodeTargets& targets,
+                                        bool srgb)
 {
-    EngineLog::logger->trace("Creating texture");
-    Texture texture{};
     ktxTexture2* kTexture;
     KTX_error_code result =
         ktxTexture2_CreateFromMemory(ktxData, ktxSize, KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &kTexture);
-    EngineLog::logger->trace("KTX texture loaded from memory");
 
     if (result != KTX_SUCCESS) {
         throw std::runtime_error("failed to load ktx texture image!");
     }
 
+    DecodedTexture decoded{};
+    decoded.ktx.reset(kTexture);
+
     if (kTexture->classId != ktxTexture2_c) {
         throw std::runtime_error("not a ktx2 texture!");
     }
 
-    auto* ktx2 = reinterpret_cast<ktxTexture2*>(kTexture);
-
-    if (ktxTexture2_NeedsTranscoding(ktx2)) {
-        if (ktxTexture2_TranscodeBasis(ktx2, KTX_TTF_RGBA32, 0) != KTX_SUCCESS)
-            throw std::runtime_error("Failed to transcode KTX2 texture to RGBA32");
-        texture.imageFormat = vk::Format::eR8G8B8A8Unorm;
+    if (ktxTexture2_NeedsTranscoding(kTexture)) {
+        const TranscodeTarget& target = ktxTexture2_GetNumComponents(kTexture) == 4 ? targets.alpha : targets.opaque;
+        if (ktxTexture2_TranscodeBasis(kTexture, target.format, 0) != KTX_SUCCESS)
+            throw std::runtime_error("Failed to transcode KTX2 texture to " + vk::to_string(target.unorm));
+        decoded.format = srgb ? target.srgb : target.unorm;
     } else {
-        texture.imageFormat = static_cast<vk::Format>(ktx2->vkFormat);
+        // The shader encodes whatever it samples, so color data stored as UNORM would come out encoded twice
+        decoded.format = static_cast<vk::Format>(kTexture->vkFormat);
+        if (srgb)
+            decoded.format = getSrgbFormat(decoded.format);
     }
+    return decoded;
+}
 
-    size_t totalSize = kTexture->dataSize;
-    uint8_t* ktxTextureData = kTexture->pData;
+vk::Format GNVEngine::getSrgbFormat(vk::Format format)
+{
+    switch (format) {
+    case vk::Format::eR8Unorm:
+        return vk::Format::eR8Srgb;
+    case vk::Format::eR8G8Unorm:
+        return vk::Format::eR8G8Srgb;
+    case vk::Format::eR8G8B8Unorm:
+        return vk::Format::eR8G8B8Srgb;
+    case vk::Format::eB8G8R8Unorm:
+        return vk::Format::eB8G8R8Srgb;
+    case vk::Format::eR8G8B8A8Unorm:
+        return vk::Format::eR8G8B8A8Srgb;
+    case vk::Format::eB8G8R8A8Unorm:
+        return vk::Format::eB8G8R8A8Srgb;
+    case vk::Format::eA8B8G8R8UnormPack32:
+        return vk::Format::eA8B8G8R8SrgbPack32;
+    case vk::Format::eBc1RgbUnormBlock:
+        return vk::Format::eBc1RgbSrgbBlock;
+    case vk::Format::eBc1RgbaUnormBlock:
+        return vk::Format::eBc1RgbaSrgbBlock;
+    case vk::Format::eBc2UnormBlock:
+        return vk::Format::eBc2SrgbBlock;
+    case vk::Format::eBc3UnormBlock:
+        return vk::Format::eBc3SrgbBlock;
+    case vk::Format::eBc7UnormBlock:
+        return vk::Format::eBc7SrgbBlock;
+    case vk::Format::eEtc2R8G8B8UnormBlock:
+        return vk::Format::eEtc2R8G8B8SrgbBlock;
+    case vk::Format::eEtc2R8G8B8A1UnormBlock:
+        return vk::Format::eEtc2R8G8B8A1SrgbBlock;
+    case vk::Format::eEtc2R8G8B8A8UnormBlock:
+        return vk::Format::eEtc2R8G8B8A8SrgbBlock;
+    case vk::Format::eAstc4x4UnormBlock:
+        return vk::Format::eAstc4x4SrgbBlock;
+    case vk::Format::eAstc5x5UnormBlock:
+        return vk::Format::eAstc5x5SrgbBlock;
+    case vk::Format::eAstc6x6UnormBlock:
+        return vk::Format::eAstc6x6SrgbBlock;
+    case vk::Format::eAstc8x8UnormBlock:
+        return vk::Format::eAstc8x8SrgbBlock;
+    default:
+        return format;
+    }
+}
+
+size_t GNVEngine::createTexture(DecodedTexture& decoded)
+{
+    EngineLog::logger->trace("Creating texture");
+    Texture texture{};
+    ktxTexture2* kTexture = decoded.ktx.get();
+    texture.imageFormat = decoded.format;
 
     texture.mipLevels = kTexture->numLevels;
-    if (texture.mipLevels > maxLod) {
-        maxLod = texture.mipLevels - 1;
-        createTextureSampler();
-    }
 
     texture.width = kTexture->baseWidth;
     texture.height = kTexture->baseHeight;
     EngineLog::logger->trace("KTX texture data loaded");
 
-    vk::raii::Buffer stagingBuffer({});
-    vk::raii::DeviceMemory stagingBufferMemory({});
-    createBuffer(totalSize, vk::BufferUsageFlagBits::eTransferSrc,
-                 vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingBuffer,
-                 stagingBufferMemory);
+    // Only the mip tail goes up now, updateTextureStreaming() brings in the rest as it's needed
+    std::vector<uint64_t> levelSizes(texture.mipLevels);
+    for (uint32_t level = 0; level < texture.mipLevels; level++)
+        levelSizes[level] = ktxTexture_GetImageSize(ktxTexture(kTexture), level);
+    texture.baseLevel = textureStreamer.addTexture(levelSizes, texture.width, texture.height);
+    texture.source = std::move(decoded);
+    texture.uploadHandle = uploadTextureLevels(texture, texture.baseLevel, texture.image, texture.imageView);
+    EngineLog::logger->trace("Mip tail from level {} of {} queued", texture.baseLevel, texture.mipLevels);
 
-    void* data = stagingBufferMemory.mapMemory(0, totalSize);
-    memcpy(data, ktxTextureData, totalSize);
-    stagingBufferMemory.unmapMemory();
-    EngineLog::logger->trace("Staging buffer copied");
+    texture.sampler = samplers.get(SamplerState{});
+    texture.slot = bindlessTextures.allocate();
+    bindlessTextures.set(texture.slot, *texture.imageView, texture.sampler);
+    EngineLog::logger->trace("Texture in bindless slot {}", texture.slot);
 
-    std::vector<vk::BufferImageCopy> regions;
+    textureManager.push_back(std::move(texture));
+    return textureManager.size() - 1;
+}
 
-    for (uint32_t level = 0; level < texture.mipLevels; level++) {
-        ktx_size_t offset = 0;
-        ktx_size_t mipSize = ktxTexture2_GetImageOffset(kTexture, level, 0, 0, &offset);
+UploadHandle GNVEngine::uploadTextureLevels(const Texture& texture, uint32_t baseLevel, GpuImage& image,
+                                            vk::raii::ImageView& imageView)
+{
+    ktxTexture2* kTexture = texture.source.ktx.get();
+    uint32_t levelCount = texture.mipLevels - baseLevel;
+
+    // The levels are staged as the one range of the KTX data that covers them all
+    std::vector<ktx_size_t> offsets(levelCount);
+    ktx_size_t begin = std::numeric_limits<ktx_size_t>::max();
+    ktx_size_t end = 0;
+    for (uint32_t level = 0; level < levelCount; level++) {
+        ktxTexture2_GetImageOffset(kTexture, baseLevel + level, 0, 0, &offsets[level]);
+        begin = std::min(begin, offsets[level]);
+        end = std::max(end, offsets[level] + ktxTexture_GetImageSize(ktxTexture(kTexture), baseLevel + level));
+    }
 
+    std::vector<vk::BufferImageCopy> regions;
+    for (uint32_t level = 0; level < levelCount; level++) {
         vk::BufferImageCopy region{};
-        region.setBufferOffset(offset).setBufferRowLength(0).setBufferImageHeight(0);
+        region.setBufferOffset(offsets[level] - begin).setBufferRowLength(0).setBufferImageHeight(0);
 
         vk::ImageSubresourceLayers subresourceLayers{};
         subresourceLayers.setAspectMask(vk::ImageAspectFlagBits::eColor)
@@ -1051,75 +2252,153 @@ size_t GNVEngine::createTexture(const uint8_t* ktxData, size_t ktxSize)
             .setLayerCount(1);
         region.setImageSubresource(subresourceLayers);
         vk::Extent3D extent{};
-        extent.width = kTexture->baseWidth >> level;
-        extent.height = kTexture->baseHeight >> level;
+        extent.width = std::max(texture.width >> (baseLevel + level), 1u);
+        extent.height = std::max(texture.height >> (baseLevel + level), 1u);
         extent.depth = 1;
         region.setImageExtent(extent);
 
         regions.push_back(region);
     }
 
-    createImage(texture.width, texture.height, texture.mipLevels, texture.imageFormat, vk::ImageTiling::eOptimal,
-                vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
-                vk::MemoryPropertyFlagBits::eDeviceLocal, texture.image, texture.imageMemory);
-    EngineLog::logger->trace("Image created");
-
-    transitionImageLayout(texture.image, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
-                          texture.mipLevels);
-
-    auto commandBuffer = beginSingleTimeCommands();
-    commandBuffer->copyBufferToImage(stagingBuffer, texture.image, vk::ImageLayout::eTransferDstOptimal, regions);
-    endSingleTimeCommands(*commandBuffer);
+    createImage(std::max(texture.width >> baseLevel, 1u), std::max(texture.height >> baseLevel, 1u), levelCount,
+                texture.imageFormat, vk::ImageTiling::eOptimal,
+                vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, image);
+    imageView = createImageView(*image, texture.imageFormat, vk::ImageAspectFlagBits::eColor, levelCount);
 
-    transitionImageLayout(texture.image, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
-                          texture.mipLevels);
-    EngineLog::logger->trace("Transition + copy to image");
+    // The data is copied into the staging ring here
+    return uploads.uploadImage(kTexture->pData + begin, end - begin, *image, levelCount, regions);
+}
 
-    ktxTexture2_Destroy(kTexture);
+void GNVEngine::updateTextureStreaming()
+{
+    frameNumber++;
+    textureStreamer.setBudget(static_cast<uint64_t>(settings.textureBudgetMiB) * 1024 * 1024);
+
+    // A change whose upload has landed replaces the texture's image in its bindless slot. Frames in flight may still
+    // sample the old one, so it's kept until they're done.
+    for (uint32_t i = 0; i < textureManager.size(); ++i) {
+        Texture& texture = textureManager[i];
+        if (!texture.pending.has_value() || !uploads.isComplete(texture.pending->uploadHandle))
+            continue;
+        retiredTextures.push_back(
+            RetiredTexture{ std::move(texture.image), std::move(texture.imageView), frameNumber });
+        texture.image = std::move(texture.pending->image);
+        texture.imageView = std::move(texture.pending->imageView);
+        texture.baseLevel = texture.pending->baseLevel;
+        texture.uploadHandle = texture.pending->uploadHandle;
+        texture.pending.reset();
+        textureStreamer.commit(i);
+        bindlessTextures.set(texture.slot, *texture.imageView, texture.sampler);
+    }
+    std::erase_if(retiredTextures, [&](const RetiredTexture& retired) {
+        return frameNumber - retired.frame >= MAX_FRAMES_IN_FLIGHT;
+    });
 
-    texture.imageView =
-        createImageView(texture.image, texture.imageFormat, vk::ImageAspectFlagBits::eColor, texture.mipLevels);
+    if (textureManager.empty())
+        return;
 
-    textureManager.push_back(std::move(texture));
+    // Each texture is assumed to cover its mesh once, so the level wanted is the one with about as many texels across
+    // as the mesh's bounds are pixels across
+    streamingObjects.clear();
+    sceneBvh.cull(Frustum::fromMatrix(ubo.proj * ubo.view * ubo.model), streamingObjects);
+    glm::vec3 cameraPosition = glm::vec3(glm::inverse(ubo.view * ubo.model) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    float pixelsPerUnit = getLodErrorScale(ubo.proj, static_cast<float>(swapChainExtent.height));
+    for (uint32_t i : streamingObjects) {
+        const Mesh& mesh = meshManager[objectMeshes[i]];
+        if (mesh.textureIndex >= textureManager.size())
+            continue;
+        const Texture& texture = textureManager[mesh.textureIndex];
+        Aabb bounds = objectTransforms[i].getBounds();
+        glm::vec3 outside =
+            glm::max(glm::max(bounds.min - cameraPosition, cameraPosition - bounds.max), glm::vec3(0.0f));
+        float screenSize = pixelsPerUnit * glm::length(bounds.max - bounds.min) /
+                           std::max(glm::length(outside), TEXTURE_STREAMING_MIN_DISTANCE);
+        uint32_t level = getTextureLevelForSize(std::max(texture.width, texture.height), screenSize, texture.mipLevels);
+        textureStreamer.request(static_cast<uint32_t>(mesh.textureIndex), level, frameNumber);
+    }
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        addTextureToBindless(descriptorSets[i], textureManager.back(),
-                             static_cast<uint32_t>(textureManager.size() - 1));
+    for (const ResidencyChange& change : textureStreamer.update(frameNumber, TEXTURE_STREAMING_CHANGES_PER_FRAME)) {
+        Texture& texture = textureManager[change.texture];
+        Texture::PendingLevels pending{};
+        pending.baseLevel = change.level;
+        pending.uploadHandle = uploadTextureLevels(texture, change.level, pending.image, pending.imageView);
+        texture.pending = std::move(pending);
+        EngineLog::logger->trace("Texture {} streaming to level {}", change.texture, change.level);
     }
-    return textureManager.size() - 1;
 }
 
-void GNVEngine::transitionImageLayout(const vk::raii::Image& image, vk::ImageLayout oldLayout,
-                                      vk::ImageLayout newLayout, uint32_t mipLevels)
+void GNVEngine::defragmentTextures()
 {
-    auto commandBuffer = beginSingleTimeCommands();
-
-    vk::ImageMemoryBarrier barrier{};
-    vk::ImageSubresourceRange range{};
-    range.setAspectMask(vk::ImageAspectFlagBits::eColor).setBaseMipLevel(0).setLevelCount(mipLevels).setLayerCount(1);
-    barrier.setOldLayout(oldLayout).setNewLayout(newLayout).setImage(*image).setSubresourceRange(range);
-
-    vk::PipelineStageFlags sourceStage;
-    vk::PipelineStageFlags destinationStage;
-
-    if (oldLayout == vk::ImageLayout::eUndefined && newLayout == vk::ImageLayout::eTransferDstOptimal) {
-        barrier.srcAccessMask = {};
-        barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
-
-        sourceStage = vk::PipelineStageFlagBits::eTopOfPipe;
-        destinationStage = vk::PipelineStageFlagBits::eTransfer;
-    } else if (oldLayout == vk::ImageLayout::eTransferDstOptimal &&
-               newLayout == vk::ImageLayout::eShaderReadOnlyOptimal) {
-        barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-        barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-
-        sourceStage = vk::PipelineStageFlagBits::eTransfer;
-        destinationStage = vk::PipelineStageFlagBits::eFragmentShader;
-    } else {
-        throw std::invalid_argument("unsupported layout transition!");
+    // Moved images may still be sampled by frames in flight or written by uploads, and retired ones can go now
+    uploads.flush();
+    device.waitIdle();
+    retiredTextures.clear();
+
+    // Render targets have dedicated allocations that never move, so only textures are sub-allocated images anyway
+    std::unordered_map<const GpuImage*, vk::raii::ImageView*> views;
+    for (Texture& texture : textureManager) {
+        views[&texture.image] = &texture.imageView;
+        if (texture.pending.has_value())
+            views[&texture.pending->image] = &texture.pending->imageView;
     }
-    commandBuffer->pipelineBarrier(sourceStage, destinationStage, {}, {}, nullptr, barrier);
-    endSingleTimeCommands(*commandBuffer);
+    std::vector<GpuImage*> moved;
+    auto stats = allocator.defragmentImages(
+        [&](const GpuImage& image) { return views.contains(&image); },
+        [&](const std::vector<GpuAllocator::ImageMove>& moves) {
+            auto commandBuffer = beginSingleTimeCommands();
+            auto barrier = [](vk::Image image, uint32_t levels, vk::ImageLayout from, vk::ImageLayout to) {
+                vk::ImageMemoryBarrier2 imageBarrier{};
+                imageBarrier.setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+                    .setSrcAccessMask(vk::AccessFlagBits2::eMemoryWrite)
+                    .setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+                    .setDstAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite)
+                    .setOldLayout(from)
+                    .setNewLayout(to)
+                    .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                    .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                    .setImage(image)
+                    .setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, levels, 0, 1));
+                return imageBarrier;
+            };
+
+            std::vector<vk::ImageMemoryBarrier2> barriers;
+            for (const auto& move : moves) {
+                uint32_t levels = move.image->getInfo().mipLevels;
+                barriers.push_back(barrier(**move.image, levels, vk::ImageLayout::eShaderReadOnlyOptimal,
+                                           vk::ImageLayout::eTransferSrcOptimal));
+                barriers.push_back(
+                    barrier(move.newImage, levels, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal));
+            }
+            commandBuffer->pipelineBarrier2(vk::DependencyInfo().setImageMemoryBarriers(barriers));
+
+            barriers.clear();
+            for (const auto& move : moves) {
+                const vk::ImageCreateInfo& info = move.image->getInfo();
+                std::vector<vk::ImageCopy> regions;
+                for (uint32_t level = 0; level < info.mipLevels; ++level) {
+                    vk::ImageSubresourceLayers layers(vk::ImageAspectFlagBits::eColor, level, 0, 1);
+                    vk::Extent3D extent{ std::max(info.extent.width >> level, 1u),
+                                         std::max(info.extent.height >> level, 1u), 1 };
+                    regions.emplace_back(layers, vk::Offset3D{}, layers, vk::Offset3D{}, extent);
+                }
+                commandBuffer->copyImage(**move.image, vk::ImageLayout::eTransferSrcOptimal, move.newImage,
+                                         vk::ImageLayout::eTransferDstOptimal, regions);
+                barriers.push_back(barrier(move.newImage, info.mipLevels, vk::ImageLayout::eTransferDstOptimal,
+                                           vk::ImageLayout::eShaderReadOnlyOptimal));
+                moved.push_back(move.image);
+            }
+            commandBuffer->pipelineBarrier2(vk::DependencyInfo().setImageMemoryBarriers(barriers));
+            endSingleTimeCommands(*commandBuffer);
+        });
+
+    for (GpuImage* image : moved)
+        *views[image] = createImageView(**image, image->getInfo().format, vk::ImageAspectFlagBits::eColor,
+                                        image->getInfo().mipLevels);
+    for (const Texture& texture : textureManager)
+        bindlessTextures.set(texture.slot, *texture.imageView, texture.sampler);
+    EngineLog::logger->info("Defragmentation moved {} images ({} bytes), freed {} blocks ({} bytes)",
+                            stats.allocationsMoved, stats.bytesMoved, stats.deviceMemoryBlocksFreed,
+                            stats.bytesFreed);
 }
 
 std::unique_ptr<vk::raii::CommandBuffer> GNVEngine::beginSingleTimeCommands()
@@ -1146,49 +2425,119 @@ void GNVEngine::endSingleTimeCommands(const vk::raii::CommandBuffer& commandBuff
     queue.waitIdle();
 }
 
-void GNVEngine::copyBufferToImage(const vk::raii::Buffer& buffer, vk::raii::Image& image, uint32_t width,
-                                  uint32_t height)
-{
-    std::unique_ptr<vk::raii::CommandBuffer> commandBuffer = beginSingleTimeCommands();
-    vk::BufferImageCopy region{};
-    region.setBufferOffset(0)
-        .setBufferRowLength(0)
-        .setBufferImageHeight(0)
-        .setImageSubresource({ vk::ImageAspectFlagBits::eColor, 0, 0, 1 })
-        .setImageOffset({ 0, 0, 0 })
-        .setImageExtent({ width, height, 1 });
-    commandBuffer->copyBufferToImage(*buffer, *image, vk::ImageLayout::eTransferDstOptimal, { region });
-    endSingleTimeCommands(*commandBuffer);
-}
-
-void GNVEngine::createTextureSampler()
-{
-    vk::PhysicalDeviceProperties properties = physicalDevice.getProperties();
-    vk::SamplerCreateInfo samplerInfo{};
-    samplerInfo.setMagFilter(vk::Filter::eLinear)
-        .setMinFilter(vk::Filter::eLinear)
-        .setMipmapMode(vk::SamplerMipmapMode::eLinear)
-        .setAddressModeU(vk::SamplerAddressMode::eRepeat)
-        .setAddressModeV(vk::SamplerAddressMode::eRepeat)
-        .setAddressModeW(vk::SamplerAddressMode::eRepeat)
-        .setMipLodBias(0.0f)
-        .setMinLod(0.0f)
-        .setMaxLod(static_cast<float>(maxLod))
-        .setAnisotropyEnable(vk::True)
-        .setMaxAnisotropy(properties.limits.maxSamplerAnisotropy)
-        .setCompareEnable(vk::False)
-        .setCompareOp(vk::CompareOp::eAlways);
-    textureSampler = vk::raii::Sampler(device, samplerInfo);
+void GNVEngine::createBindlessTable()
+{
+    uint32_t capacity = BindlessTable::getDeviceCapacity(physicalDevice, MAX_TEXTURES);
+    bindlessTextures = BindlessTable(device, 3, capacity, MAX_FRAMES_IN_FLIGHT);
+    samplers = SamplerCache(device, physicalDevice);
+    EngineLog::logger->info("Bindless texture table: {} slots", capacity);
 }
 
-void GNVEngine::loadModel()
+Aabb GNVEngine::decodePrimitive(const fastgltf::Asset& asset, const fastgltf::Primitive& primitive,
+                                std::span<Vertex> vertices, std::span<uint32_t> indices, uint32_t baseIndex)
 {
-    EngineLog::logger->trace("Loading {}", MODEL_PATH);
-    std::filesystem::path path{ MODEL_PATH };
-    if (!std::filesystem::exists(path)) {
-        EngineLog::logger->error("GLB file not found: {}", path.string());
-        return;
+    Aabb bounds{};
+    auto* posAttr = primitive.findAttribute("POSITION");
+    if (posAttr != primitive.attributes.end()) {
+        auto& posAccessor = asset.accessors[posAttr->accessorIndex];
+        if (posAccessor.type != fastgltf::AccessorType::Vec3) {
+            EngineLog::logger->error("POSITION accessor is not VEC3!");
+        }
+        if (!posAccessor.bufferViewIndex.has_value()) {
+            EngineLog::logger->error("Position accessor missing bufferView!");
+        }
+        fastgltf::iterateAccessorWithIndex<fastgltf::math::fvec3>(
+            asset, posAccessor, [&](fastgltf::math::fvec3 pos, std::size_t idx) {
+                glm::vec3 vert{ pos.x(), pos.y(), pos.z() };
+                vertices[idx].pos = vert;
+                bounds.expand(vert);
+            });
+        EngineLog::logger->trace("Vertex positions loaded {}, Min:{}, Max:{}", posAccessor.count,
+                                 glm::to_string(bounds.min), glm::to_string(bounds.max));
+    }
+
+    auto* texAttr = primitive.findAttribute("TEXCOORD_0");
+    if (texAttr != primitive.attributes.end()) {
+        auto& texAccessor = asset.accessors[texAttr->accessorIndex];
+        if (texAccessor.type != fastgltf::AccessorType::Vec2) {
+            EngineLog::logger->error("TEXTURE accessor is not VEC2: {} AccessorIndex:{}", int(texAccessor.type),
+                                     texAttr->accessorIndex);
+        }
+        fastgltf::iterateAccessorWithIndex<fastgltf::math::fvec2>(
+            asset, texAccessor,
+            [&](fastgltf::math::fvec2 uv, std::size_t idx) { vertices[idx].texCoord = glm::vec2(uv.x(), uv.y()); });
+        EngineLog::logger->trace("UVs loaded {}", texAccessor.count);
+    } else {
+        for (auto& vertex : vertices)
+            vertex.texCoord = glm::vec2(0.0f);
+        EngineLog::logger->trace("UVs loaded empty");
+    }
+
+    if (primitive.indicesAccessor.has_value()) {
+        auto& indexAccessor = asset.accessors[primitive.indicesAccessor.value()];
+        if (indexAccessor.type != fastgltf::AccessorType::Scalar) {
+            EngineLog::logger->error("INDEX accessor is not SCALAR!");
+        }
+        if (!indexAccessor.bufferViewIndex.has_value())
+            throw std::runtime_error("Index accessor missing buffer view");
+        if (indexAccessor.componentType != fastgltf::ComponentType::UnsignedByte &&
+            indexAccessor.componentType != fastgltf::ComponentType::UnsignedShort &&
+            indexAccessor.componentType != fastgltf::ComponentType::UnsignedInt) {
+            throw std::runtime_error("Unsupported index type in glTF");
+        }
+        // Widened and rebased straight into the mesh's index array
+        fastgltf::iterateAccessorWithIndex<uint32_t>(
+            asset, indexAccessor, [&](uint32_t index, std::size_t idx) { indices[idx] = baseIndex + index; });
+        EngineLog::logger->trace("Indices loaded {}", indexAccessor.count);
     }
+    return bounds;
+}
+
+GNVEngine::MeshOptimizeStats GNVEngine::optimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    // Cache size as in meshoptimizer's own analysis defaults
+    constexpr unsigned int cacheSize = 16;
+    constexpr float overdrawThreshold = 1.05f;
+
+    MeshOptimizeStats stats{};
+    stats.verticesBefore = vertices.size();
+    stats.before = meshopt_analyzeVertexCache(indices.data(), indices.size(), vertices.size(), cacheSize, 0, 0);
+    if (indices.empty() || vertices.empty()) {
+        stats.after = stats.before;
+        stats.verticesAfter = stats.verticesBefore;
+        return stats;
+    }
+
+    // Merge bitwise identical vertices
+    std::vector<unsigned int> remap(vertices.size());
+    size_t uniqueCount = meshopt_generateVertexRemap(remap.data(), indices.data(), indices.size(), vertices.data(),
+                                                     vertices.size(), sizeof(Vertex));
+    meshopt_remapIndexBuffer(indices.data(), indices.data(), indices.size(), remap.data());
+    meshopt_remapVertexBuffer(vertices.data(), vertices.data(), vertices.size(), sizeof(Vertex), remap.data());
+    vertices.resize(uniqueCount);
+
+    meshopt_optimizeVertexCache(indices.data(), indices.data(), indices.size(), vertices.size());
+    meshopt_optimizeOverdraw(indices.data(), indices.data(), indices.size(), &vertices[0].pos.x, vertices.size(),
+                             sizeof(Vertex), overdrawThreshold);
+    // Also drops vertices no triangle references
+    size_t fetchedCount = meshopt_optimizeVertexFetch(vertices.data(), indices.data(), indices.size(), vertices.data(),
+                                                      vertices.size(), sizeof(Vertex));
+    vertices.resize(fetchedCount);
+
+    stats.verticesAfter = vertices.size();
+    stats.after = meshopt_analyzeVertexCache(indices.data(), indices.size(), vertices.size(), cacheSize, 0, 0);
+    return stats;
+}
+
+CookedModel GNVEngine::cookModel(const std::filesystem::path& path, const CookedModelSource& source,
+                                 const std::filesystem::path& cookedPath)
+{
+    using Clock = std::chrono::high_resolution_clock;
+    auto elapsedMs = [](Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    };
+
+    auto parseStart = Clock::now();
     static constexpr auto supportedExtensions =
         fastgltf::Extensions::KHR_mesh_quantization | fastgltf::Extensions::KHR_texture_transform |
         fastgltf::Extensions::KHR_materials_variants | fastgltf::Extensions::KHR_texture_basisu |
@@ -1204,148 +2553,462 @@ void GNVEngine::loadModel()
     EngineLog::logger->trace("Materials: {}", asset.materials.size());
     EngineLog::logger->trace("Meshes: {}", asset.meshes.size());
     EngineLog::logger->trace("Nodes: {}", asset.nodes.size());
+    auto parseEnd = Clock::now();
 
-    std::vector<size_t> textureIndices(asset.images.size());
-    for (size_t i = 0; i < asset.images.size(); ++i) {
-        auto& image = asset.images[i];
+    CookedModelWriter writer;
+
+    // KTX2 images are embedded untouched, Basis transcoding depends on the device and happens at load time
+    for (auto& image : asset.images) {
         auto& view = std::get<fastgltf::sources::BufferView>(image.data);
         auto& bufferView = asset.bufferViews[view.bufferViewIndex];
-        auto& buffer = asset.buffers[bufferView.bufferIndex];
-        auto& vector = std::get<fastgltf::sources::Array>(buffer.data);
-        auto ktxData = reinterpret_cast<const uint8_t*>(vector.bytes.data() + bufferView.byteOffset);
-        size_t ktxSize = bufferView.byteLength;
-
-        textureIndices[i] = createTexture(ktxData, ktxSize);
+        auto& vector = std::get<fastgltf::sources::Array>(asset.buffers[bufferView.bufferIndex].data);
+        writer.addImage(
+            std::span<const std::byte>(vector.bytes.data() + bufferView.byteOffset, bufferView.byteLength));
     }
-    EngineLog::logger->trace("Textures loaded");
 
-    for (auto& aMesh : asset.meshes) {
-        Mesh mesh{};
-        uint32_t offset = 0;
-
-        if (!aMesh.primitives.empty() && aMesh.primitives[0].materialIndex.has_value()) {
-            size_t materialIdx = aMesh.primitives[0].materialIndex.value();
-            auto& material = asset.materials[materialIdx];
-            if (material.pbrData.baseColorTexture.has_value()) {
-                size_t imageIdx = material.pbrData.baseColorTexture->textureIndex;
-                mesh.textureIndex = textureIndices[imageIdx];
-            } else {
-                mesh.textureIndex = 0;
+    for (auto& material : asset.materials) {
+        CookedMaterial cooked{};
+        if (material.pbrData.baseColorTexture.has_value()) {
+            size_t textureIdx = material.pbrData.baseColorTexture->textureIndex;
+            auto& texture = asset.textures[textureIdx];
+            size_t imageIdx = textureIdx;
+            if (texture.basisuImageIndex.has_value()) {
+                imageIdx = texture.basisuImageIndex.value();
+            } else if (texture.imageIndex.has_value()) {
+                imageIdx = texture.imageIndex.value();
             }
+            cooked.baseColorImage = static_cast<int32_t>(imageIdx);
         }
-        EngineLog::logger->trace("Textures index found {}", mesh.textureIndex);
-        EngineLog::logger->trace("Now loading primitives {}", aMesh.primitives.size());
+        cooked.doubleSided = material.doubleSided;
+        writer.addMaterial(cooked);
+    }
 
-        for (auto& aPrimitive : aMesh.primitives) {
+    // Meshes: size every mesh up front from the accessor counts so each primitive decodes into its own slice
+    struct PrimitiveJob {
+        size_t meshIdx;
+        size_t primitiveIdx;
+        size_t vertexOffset;
+        size_t vertexCount;
+        size_t indexOffset;
+        size_t indexCount;
+        Aabb bounds;
+    };
+    std::vector<std::vector<Vertex>> vertices(asset.meshes.size());
+    std::vector<std::vector<uint32_t>> indices(asset.meshes.size());
+    std::vector<PrimitiveJob> primitiveJobs;
+    for (size_t m = 0; m < asset.meshes.size(); ++m) {
+        auto& aMesh = asset.meshes[m];
+        size_t vertexCount = 0;
+        size_t indexCount = 0;
+        for (size_t p = 0; p < aMesh.primitives.size(); ++p) {
+            auto& aPrimitive = aMesh.primitives[p];
+            PrimitiveJob job{ m, p, vertexCount, 0, indexCount, 0, {} };
             auto* posAttr = aPrimitive.findAttribute("POSITION");
-            size_t primitiveVertexCount = 0;
-            size_t baseIndex = mesh.vertices.size();
-            if (posAttr) {
-                auto& posAccessor = asset.accessors[posAttr->accessorIndex];
-                if (posAccessor.type != fastgltf::AccessorType::Vec3) {
-                    EngineLog::logger->error("POSITION accessor is not VEC3!");
-                }
-                primitiveVertexCount = posAccessor.count;
-                EngineLog::logger->trace("Attr found POSITION, resizing {}", baseIndex + primitiveVertexCount);
-                mesh.vertices.resize(baseIndex + primitiveVertexCount);
+            if (posAttr != aPrimitive.attributes.end())
+                job.vertexCount = asset.accessors[posAttr->accessorIndex].count;
+            if (aPrimitive.indicesAccessor.has_value())
+                job.indexCount = asset.accessors[aPrimitive.indicesAccessor.value()].count;
+            vertexCount += job.vertexCount;
+            indexCount += job.indexCount;
+            primitiveJobs.push_back(job);
+        }
+        vertices[m].resize(vertexCount);
+        indices[m].resize(indexCount);
+        EngineLog::logger->trace("Mesh {}: {} primitives, {} vertices, {} indices", m, aMesh.primitives.size(),
+                                 vertexCount, indexCount);
+    }
 
-                if (!posAccessor.bufferViewIndex.has_value()) {
-                    EngineLog::logger->error("Position accessor missing bufferView!");
-                }
-                EngineLog::logger->trace("Byte offset:{}, Count:{}, Vec size:{}, Byte length:{}",
-                                         posAccessor.byteOffset, posAccessor.count, sizeof(fastgltf::math::fvec3),
-                                         asset.bufferViews[posAccessor.bufferViewIndex.value()].byteLength);
-                glm::vec3 min{};
-                glm::vec3 max{};
-                fastgltf::iterateAccessorWithIndex<fastgltf::math::fvec3>(
-                    asset, posAccessor, [&](fastgltf::math::fvec3 pos, std::size_t idx) {
-                        glm::vec3 vert{ pos.x(), pos.y(), pos.z() };
-                        mesh.vertices[baseIndex + idx].pos = vert;
-                        min = glm::min(min, vert);
-                        max = glm::max(max, vert);
-                    });
-                EngineLog::logger->trace("Vertex positions loaded {}, Min:{}, Max:{}", posAccessor.count,
-                                         glm::to_string(min), glm::to_string(max));
-            }
+    BS::multi_future<void> primitiveTasks =
+        threadPool.submit_loop<size_t>(0, primitiveJobs.size(), [&](size_t j) {
+            PrimitiveJob& job = primitiveJobs[j];
+            job.bounds = decodePrimitive(asset, asset.meshes[job.meshIdx].primitives[job.primitiveIdx],
+                                         std::span(vertices[job.meshIdx]).subspan(job.vertexOffset, job.vertexCount),
+                                         std::span(indices[job.meshIdx]).subspan(job.indexOffset, job.indexCount),
+                                         static_cast<uint32_t>(job.vertexOffset));
+        });
+    // get() rethrows the first exception a worker hit as soon as it gets to it, without waiting for the rest, which
+    // still use the locals captured by reference. Every submit_loop in this file wait()s for all of them first.
+    primitiveTasks.wait();
+    primitiveTasks.get();
+
+    std::vector<Aabb> bounds(asset.meshes.size());
+    for (auto& job : primitiveJobs)
+        bounds[job.meshIdx].expand(job.bounds);
+
+    // Models that skipped gltfpack get the same treatment here, the rest come out about the same
+    std::vector<MeshOptimizeStats> optimizeStats(asset.meshes.size());
+    BS::multi_future<void> optimizeTasks = threadPool.submit_loop<size_t>(
+        0, asset.meshes.size(), [&](size_t m) { optimizeStats[m] = optimizeMesh(vertices[m], indices[m]); });
+    optimizeTasks.wait();
+    optimizeTasks.get();
+
+    // ACMR is transformed vertices per triangle, ATVR per vertex, both summed over every mesh
+    size_t triangles = 0;
+    MeshOptimizeStats totals{};
+    for (size_t m = 0; m < asset.meshes.size(); ++m) {
+        triangles += indices[m].size() / 3;
+        totals.before.vertices_transformed += optimizeStats[m].before.vertices_transformed;
+        totals.after.vertices_transformed += optimizeStats[m].after.vertices_transformed;
+        totals.verticesBefore += optimizeStats[m].verticesBefore;
+        totals.verticesAfter += optimizeStats[m].verticesAfter;
+        EngineLog::logger->trace("Mesh {} optimized: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", m,
+                                 optimizeStats[m].before.acmr, optimizeStats[m].after.acmr,
+                                 optimizeStats[m].before.atvr, optimizeStats[m].after.atvr);
+    }
+    if (triangles > 0 && totals.verticesAfter > 0) {
+        auto ratio = [](size_t transformed, size_t count) { return static_cast<double>(transformed) / count; };
+        EngineLog::logger->info("Optimized meshes: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}, {} -> {} vertices",
+                                ratio(totals.before.vertices_transformed, triangles),
+                                ratio(totals.after.vertices_transformed, triangles),
+                                ratio(totals.before.vertices_transformed, totals.verticesBefore),
+                                ratio(totals.after.vertices_transformed, totals.verticesAfter), totals.verticesBefore,
+                                totals.verticesAfter);
+    }
 
-            auto* texAttr = aPrimitive.findAttribute("TEXCOORD_0");
-            if (texAttr != aPrimitive.attributes.end()) {
-                auto& texAccessor = asset.accessors[texAttr->accessorIndex];
-                if (texAccessor.type != fastgltf::AccessorType::Vec2) {
-                    EngineLog::logger->error("TEXTURE accessor is not VEC2: {} AccessorIndex:{}", int(texAccessor.type),
-                                             texAttr->accessorIndex);
-                }
-                fastgltf::iterateAccessorWithIndex<fastgltf::math::fvec2>(
-                    asset, texAccessor, [&](fastgltf::math::fvec2 uv, std::size_t idx) {
-                        mesh.vertices[baseIndex + idx].texCoord = glm::vec2(uv.x(), uv.y());
-                    });
-                EngineLog::logger->trace("UVs loaded {}", texAccessor.count);
+    // Every cooked mesh gets 16-bit indices when its vertices fit. Bigger meshes are split into windows of
+    // triangles that each address at most 65536 vertices, and each window is cooked as a mesh of its own with a
+    // copy of the vertices it spans. Meshes that don't split cleanly keep 32-bit indices.
+    struct CookUnit {
+        size_t meshIdx;
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        Aabb bounds;
+        // Indices get narrowed to shortIndices once the LODs are in, they index the same vertices
+        bool fitsUint16;
+        // One of several windows of a mesh, its open edges have to stay where the neighbouring windows expect them
+        bool split;
+        std::vector<PackedVertex> packedVertices;
+        std::vector<uint16_t> shortIndices;
+        std::vector<CookedMeshlet> meshlets;
+        CookedMesh cooked;
+    };
+    std::vector<CookUnit> units;
+    for (size_t m = 0; m < asset.meshes.size(); ++m) {
+        std::vector<IndexWindow> windows = splitIndexWindows(indices[m]);
+        size_t windowVertices = 0;
+        for (auto& window : windows)
+            windowVertices += window.maxVertex - window.minVertex + 1;
+        // Overlapping windows duplicate vertices, past a point the wider indices are cheaper
+        if (windows.empty() || windowVertices > vertices[m].size() + vertices[m].size() / 2) {
+            units.push_back(
+                CookUnit{ m, std::move(vertices[m]), std::move(indices[m]), bounds[m], false, false, {}, {}, {}, {} });
+            continue;
+        }
+        for (auto& window : windows) {
+            CookUnit unit{ m, {}, {}, {}, true, windows.size() > 1, {}, {}, {}, {} };
+            unit.vertices.assign(vertices[m].begin() + window.minVertex, vertices[m].begin() + window.maxVertex + 1);
+            unit.indices.reserve(window.indexCount);
+            for (size_t i = window.firstIndex; i < window.firstIndex + window.indexCount; ++i)
+                unit.indices.push_back(indices[m][i] - window.minVertex);
+            if (windows.size() == 1) {
+                unit.bounds = bounds[m];
             } else {
-                for (size_t i = 0; i < primitiveVertexCount; ++i)
-                    mesh.vertices[baseIndex + i].texCoord = glm::vec2(0.0f);
-                EngineLog::logger->trace("UVs loaded empty");
+                for (const Vertex& vertex : unit.vertices)
+                    unit.bounds.expand(vertex.pos);
             }
+            units.push_back(std::move(unit));
+        }
+    }
 
-            if (aPrimitive.indicesAccessor.has_value()) {
-                auto& indexAccessor = asset.accessors[aPrimitive.indicesAccessor.value()];
-                if (indexAccessor.type != fastgltf::AccessorType::Scalar) {
-                    EngineLog::logger->error("INDEX accessor is not SCALAR!");
-                }
-                if (!indexAccessor.bufferViewIndex.has_value())
-                    throw std::runtime_error("Index accessor missing buffer view");
-                size_t oldIndexCount = mesh.indices.size();
-                mesh.indices.resize(oldIndexCount + indexAccessor.count);
-
-                if (indexAccessor.componentType == fastgltf::ComponentType::UnsignedByte ||
-                    indexAccessor.componentType == fastgltf::ComponentType::UnsignedShort) {
-                    std::vector<uint16_t> tempIndices(indexAccessor.count);
-                    fastgltf::copyFromAccessor<uint16_t>(asset, indexAccessor, tempIndices.data());
-                    for (size_t i = 0; i < tempIndices.size(); ++i) {
-                        mesh.indices[oldIndexCount + i] = baseIndex + static_cast<uint32_t>(tempIndices[i]);
-                    }
-                } else if (indexAccessor.componentType == fastgltf::ComponentType::UnsignedInt) {
-                    std::vector<uint32_t> tempIndices(indexAccessor.count);
-                    fastgltf::copyFromAccessor<uint32_t>(asset, indexAccessor, tempIndices.data());
-                    for (size_t i = 0; i < tempIndices.size(); ++i) {
-                        mesh.indices[oldIndexCount + i] = baseIndex + tempIndices[i];
-                    }
-                } else {
-                    throw std::runtime_error("Unsupported index type in glTF");
-                }
-                EngineLog::logger->trace("Indices loaded {}", indexAccessor.count);
-            }
-            offset += primitiveVertexCount;
+    // Build each unit's LOD chain and meshlets from the float positions, then quantize it against its own bounds and
+    // UV range so 16 bits cover only the space it actually uses
+    BS::multi_future<void> packTasks = threadPool.submit_loop<size_t>(0, units.size(), [&](size_t u) {
+        CookUnit& unit = units[u];
+        CookedMesh& cooked = unit.cooked;
+        const float* positions = unit.vertices.empty() ? nullptr : &unit.vertices[0].pos.x;
+        std::vector<MeshLod> lods =
+            buildLodChain(unit.indices, positions, unit.vertices.size(), sizeof(Vertex), unit.split);
+        for (const MeshLod& lod : lods) {
+            auto lodIndices = std::span(unit.indices).subspan(lod.firstIndex, lod.indexCount);
+            std::vector<CookedMeshlet> meshlets =
+                buildMeshlets(lodIndices, positions, unit.vertices.size(), sizeof(Vertex));
+            for (CookedMeshlet& meshlet : meshlets)
+                meshlet.firstIndex += lod.firstIndex;
+            cooked.lods.push_back(
+                CookedLod{ lod.firstIndex, lod.indexCount, lod.error, unit.meshlets.size(), meshlets.size() });
+            unit.meshlets.insert(unit.meshlets.end(), meshlets.begin(), meshlets.end());
+        }
+        if (unit.fitsUint16) {
+            unit.shortIndices.assign(unit.indices.begin(), unit.indices.end());
+            unit.indices.clear();
+        }
+
+        cooked.boundsMin = { unit.bounds.min.x, unit.bounds.min.y, unit.bounds.min.z };
+        cooked.boundsMax = { unit.bounds.max.x, unit.bounds.max.y, unit.bounds.max.z };
+        cooked.indexStride = unit.fitsUint16 ? sizeof(uint16_t) : sizeof(uint32_t);
+        if (!settings.quantizeVertices || unit.vertices.empty()) {
+            cooked.vertexFormat = static_cast<uint32_t>(VertexFormat::Float);
+            cooked.vertexStride = getVertexStride(VertexFormat::Float);
+            return;
+        }
+
+        glm::vec2 uvMin{ std::numeric_limits<float>::max() };
+        glm::vec2 uvMax{ std::numeric_limits<float>::lowest() };
+        for (const Vertex& vertex : unit.vertices) {
+            uvMin = glm::min(uvMin, vertex.texCoord);
+            uvMax = glm::max(uvMax, vertex.texCoord);
+        }
+        glm::vec3 positionOffset = unit.bounds.min;
+        glm::vec3 positionScale = unit.bounds.max - unit.bounds.min;
+        glm::vec4 uvTransform(uvMin, uvMax - uvMin);
+
+        unit.packedVertices.reserve(unit.vertices.size());
+        for (const Vertex& vertex : unit.vertices)
+            unit.packedVertices.push_back(PackedVertex::pack(vertex, positionOffset, positionScale, uvTransform));
+
+        cooked.vertexFormat = static_cast<uint32_t>(VertexFormat::Packed);
+        cooked.vertexStride = getVertexStride(VertexFormat::Packed);
+        cooked.positionOffset = { positionOffset.x, positionOffset.y, positionOffset.z };
+        cooked.positionScale = { positionScale.x, positionScale.y, positionScale.z };
+        cooked.uvOffset = { uvTransform.x, uvTransform.y };
+        cooked.uvScale = { uvTransform.z, uvTransform.w };
+    });
+    packTasks.wait();
+    packTasks.get();
+
+    size_t floatVertexBytes = 0;
+    size_t cookedVertexBytes = 0;
+    size_t wideIndexBytes = 0;
+    size_t cookedIndexBytes = 0;
+    size_t lodCount = 0;
+    size_t baseIndexCount = 0;
+    size_t lodIndexCount = 0;
+    size_t meshletCount = 0;
+    for (CookUnit& unit : units) {
+        auto& aMesh = asset.meshes[unit.meshIdx];
+        CookedMesh& cooked = unit.cooked;
+        if (!aMesh.primitives.empty() && aMesh.primitives[0].materialIndex.has_value())
+            cooked.material = static_cast<int32_t>(aMesh.primitives[0].materialIndex.value());
+
+        auto vertexBytes = cooked.vertexFormat == static_cast<uint32_t>(VertexFormat::Packed)
+                               ? std::as_bytes(std::span(unit.packedVertices))
+                               : std::as_bytes(std::span(unit.vertices));
+        auto indexBytes = unit.fitsUint16 ? std::as_bytes(std::span(unit.shortIndices))
+                                          : std::as_bytes(std::span(unit.indices));
+        floatVertexBytes += unit.vertices.size() * sizeof(Vertex);
+        cookedVertexBytes += vertexBytes.size();
+        wideIndexBytes += (unit.indices.size() + unit.shortIndices.size()) * sizeof(uint32_t);
+        cookedIndexBytes += indexBytes.size();
+        lodCount += cooked.lods.size();
+        baseIndexCount += cooked.lods[0].indexCount;
+        lodIndexCount += indexBytes.size() / cooked.indexStride - cooked.lods[0].indexCount;
+        meshletCount += unit.meshlets.size();
+        writer.addMesh(cooked, vertexBytes, indexBytes, unit.meshlets);
+    }
+
+    // Units went in mesh by mesh, so every glTF mesh is a run of cooked meshes
+    std::vector<uint32_t> unitFirst(asset.meshes.size(), 0);
+    std::vector<uint32_t> unitCount(asset.meshes.size(), 0);
+    for (size_t u = units.size(); u-- > 0;) {
+        unitFirst[units[u].meshIdx] = static_cast<uint32_t>(u);
+        unitCount[units[u].meshIdx]++;
+    }
+
+    // Nodes of the default scene, depth first so parents go in before their children. Without a scene every node
+    // nothing points to is a root, and without nodes every mesh is drawn once where it is.
+    std::vector<size_t> roots;
+    if (!asset.scenes.empty()) {
+        const auto& scene = asset.scenes[asset.defaultScene.value_or(0)];
+        roots.assign(scene.nodeIndices.begin(), scene.nodeIndices.end());
+    } else {
+        std::vector<uint8_t> isChild(asset.nodes.size(), 0);
+        for (const auto& node : asset.nodes) {
+            for (size_t child : node.children)
+                isChild[child] = 1;
+        }
+        for (size_t n = 0; n < asset.nodes.size(); ++n) {
+            if (!isChild[n])
+                roots.push_back(n);
+        }
+    }
+    size_t nodeCount = 0;
+    auto addNode = [&](auto& self, size_t nodeIdx, int32_t parent) -> void {
+        const fastgltf::Node& node = asset.nodes[nodeIdx];
+        CookedNode cooked{};
+        cooked.parent = parent;
+        if (node.meshIndex.has_value()) {
+            cooked.firstMesh = unitFirst[node.meshIndex.value()];
+            cooked.meshCount = unitCount[node.meshIndex.value()];
+        }
+        fastgltf::math::fmat4x4 matrix = fastgltf::getTransformMatrix(node);
+        memcpy(cooked.matrix.data(), matrix.data(), sizeof(cooked.matrix));
+        int32_t index = static_cast<int32_t>(writer.addNode(cooked));
+        nodeCount++;
+        for (size_t child : node.children)
+            self(self, child, index);
+    };
+    for (size_t root : roots)
+        addNode(addNode, root, -1);
+    if (nodeCount == 0) {
+        for (size_t m = 0; m < asset.meshes.size(); ++m) {
+            writer.addNode(CookedNode{ -1, unitFirst[m], unitCount[m] });
+            nodeCount++;
+        }
+    }
+
+    std::vector<std::byte> bytes = writer.finish(source);
+    auto cookEnd = Clock::now();
+    EngineLog::logger->info("Cooked {}: parse {:.2f} ms, decode {:.2f} ms, {} primitives into {} meshes, {:.2f} MiB",
+                            path.string(), elapsedMs(parseStart, parseEnd), elapsedMs(parseEnd, cookEnd),
+                            primitiveJobs.size(), units.size(), bytes.size() / (1024.0 * 1024.0));
+    EngineLog::logger->info("  vertices {:.2f} MiB as float, {:.2f} MiB cooked", floatVertexBytes / (1024.0 * 1024.0),
+                            cookedVertexBytes / (1024.0 * 1024.0));
+    EngineLog::logger->info("  indices {:.2f} MiB as uint32, {:.2f} MiB cooked", wideIndexBytes / (1024.0 * 1024.0),
+                            cookedIndexBytes / (1024.0 * 1024.0));
+    EngineLog::logger->info("  {} LODs over {} meshes, {:.1f}% more indices than level 0 alone", lodCount,
+                            units.size(), baseIndexCount > 0 ? 100.0 * lodIndexCount / baseIndexCount : 0.0);
+    EngineLog::logger->info("  {} meshlets across every LOD", meshletCount);
+    EngineLog::logger->info("  {} nodes", nodeCount);
+
+    try {
+        CookedModel::save(cookedPath, bytes);
+    } catch (const std::exception& e) {
+        // Still loads from memory, the next run just cooks again
+        EngineLog::logger->warn("Failed to save cooked model: {}", e.what());
+    }
+    return CookedModel(std::move(bytes));
+}
+
+void GNVEngine::loadModel()
+{
+    using Clock = std::chrono::high_resolution_clock;
+    auto elapsedMs = [](Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    };
+
+    EngineLog::logger->trace("Loading {}", MODEL_PATH);
+    std::filesystem::path path{ MODEL_PATH };
+    if (!std::filesystem::exists(path)) {
+        EngineLog::logger->error("GLB file not found: {}", path.string());
+        return;
+    }
+    std::filesystem::path cookedPath = std::filesystem::path(COOKED_MODEL_DIR) / path.filename();
+    // One file per vertex layout, so switching between them doesn't re-cook every time
+    cookedPath.replace_extension(settings.quantizeVertices ? ".gnvm" : ".float.gnvm");
+
+    auto readStart = Clock::now();
+    CookedModelSource source = CookedModelSource::of(path);
+    std::optional<CookedModel> mapped = CookedModel::open(cookedPath, source);
+    // A stride mismatch means Vertex or PackedVertex changed without a COOKED_MODEL_VERSION bump
+    auto layoutMatches = [](const CookedMesh& mesh) {
+        return mesh.vertexFormat < VERTEX_FORMAT_COUNT &&
+               mesh.vertexStride == getVertexStride(static_cast<VertexFormat>(mesh.vertexFormat));
+    };
+    if (mapped.has_value() && std::ranges::all_of(mapped->getMeshes(), layoutMatches)) {
+        model = std::move(mapped.value());
+        EngineLog::logger->trace("Mapped cooked model {}", cookedPath.string());
+    } else {
+        EngineLog::logger->info("No up to date cooked model at {}, cooking {}", cookedPath.string(), path.string());
+        model = cookModel(path, source, cookedPath);
+    }
+    auto readEnd = Clock::now();
+
+    // Textures: load + Basis transcode on the workers, one task per image
+    std::atomic<int64_t> transcodeNs{ 0 };
+    const auto& images = model.getImages();
+    // Base color is the only slot, and the one that holds color data
+    std::vector<uint8_t> srgbImages(images.size(), 0);
+    for (const CookedMaterial& material : model.getMaterials()) {
+        if (material.baseColorImage >= 0 && static_cast<size_t>(material.baseColorImage) < images.size())
+            srgbImages[material.baseColorImage] = 1;
+    }
+    auto decodeImage = [&](DecodedTexture& decoded, size_t i) {
+        auto start = Clock::now();
+        auto data = model.getImageData(images[i]);
+        decoded = decodeTexture(reinterpret_cast<const uint8_t*>(data.data()), data.size(), transcodeTargets,
+                                srgbImages[i] != 0);
+        transcodeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    };
+
+    std::vector<DecodedTexture> decodedTextures(images.size());
+    // libktx sets up the Basis transcoder tables on first use without any locking, so the first image is done here
+    // before the rest fan out
+    if (!decodedTextures.empty())
+        decodeImage(decodedTextures[0], 0);
+    BS::multi_future<void> textureTasks = threadPool.submit_loop<size_t>(
+        1, decodedTextures.size(), [&](size_t i) { decodeImage(decodedTextures[i], i); });
+    textureTasks.wait();
+    textureTasks.get();
+    auto decodeEnd = Clock::now();
+
+    // GPU side stays on this thread: image/buffer creation, staging and descriptor writes
+    std::vector<size_t> textureIndices(decodedTextures.size());
+    for (size_t i = 0; i < decodedTextures.size(); ++i) {
+        textureIndices[i] = createTexture(decodedTextures[i]);
+    }
+    EngineLog::logger->trace("Textures loaded");
+
+    // Vertices and indices are already in their GPU layout, uploadMesh() copies them from the model into staging
+    for (const auto& cooked : model.getMeshes()) {
+        Mesh mesh{};
+        mesh.vertexFormat = static_cast<VertexFormat>(cooked.vertexFormat);
+        mesh.vertexCount = static_cast<uint32_t>(cooked.vertexCount);
+        mesh.vertexData = model.view<std::byte>(cooked.vertexOffset, cooked.vertexCount * cooked.vertexStride);
+        mesh.indexType = cooked.indexStride == sizeof(uint16_t) ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+        mesh.indexCount = static_cast<uint32_t>(cooked.indexCount);
+        mesh.indexData = model.view<std::byte>(cooked.indexOffset, cooked.indexCount * cooked.indexStride);
+        mesh.positionOffset = glm::vec3(cooked.positionOffset[0], cooked.positionOffset[1], cooked.positionOffset[2]);
+        mesh.positionScale = glm::vec3(cooked.positionScale[0], cooked.positionScale[1], cooked.positionScale[2]);
+        mesh.uvTransform = glm::vec4(cooked.uvOffset[0], cooked.uvOffset[1], cooked.uvScale[0], cooked.uvScale[1]);
+        mesh.bounds.min = glm::vec3(cooked.boundsMin[0], cooked.boundsMin[1], cooked.boundsMin[2]);
+        mesh.bounds.max = glm::vec3(cooked.boundsMax[0], cooked.boundsMax[1], cooked.boundsMax[2]);
+        mesh.meshlets = model.view<CookedMeshlet>(cooked.meshletOffset, cooked.meshletCount);
+        for (const CookedLod& lod : cooked.lods) {
+            mesh.lods.push_back(MeshLod{ static_cast<uint32_t>(lod.firstIndex), static_cast<uint32_t>(lod.indexCount),
+                                         lod.error, static_cast<uint32_t>(lod.firstMeshlet),
+                                         static_cast<uint32_t>(lod.meshletCount) });
+        }
+        if (cooked.material >= 0) {
+            const CookedMaterial& material = model.getMaterials()[cooked.material];
+            if (material.baseColorImage >= 0)
+                mesh.textureIndex = textureIndices[material.baseColorImage];
+            mesh.doubleSided = material.doubleSided;
         }
-        createVertexBuffer(mesh);
-        createIndexBuffer(mesh);
-        meshManager.push_back(std::move(mesh));
+        EngineLog::logger->trace("Textures index found {}", mesh.textureIndex);
+
+        uploadMesh(mesh);
+        meshManager.push_back(mesh);
+    }
+
+    UploadHandle handle = uploads.flush();
+    auto uploadEnd = Clock::now();
+    EngineLog::logger->trace("Model uploads submitted as batch {}", handle);
+
+    EngineLog::logger->info("Model load ({}): read {:.2f} ms, decode {:.2f} ms, upload {:.2f} ms ({} threads)",
+                            model.isMapped() ? "mapped" : "cooked", elapsedMs(readStart, readEnd),
+                            elapsedMs(readEnd, decodeEnd), elapsedMs(decodeEnd, uploadEnd),
+                            threadPool.get_thread_count());
+    EngineLog::logger->info("  transcode {} images: {:.2f} ms of work", decodedTextures.size(),
+                            transcodeNs.load() / 1e6);
+    uint64_t textureBytes = 0;
+    uint64_t rgba32Bytes = 0;
+    for (const Texture& texture : textureManager) {
+        textureBytes += texture.getBytes(0);
+        rgba32Bytes += texture.getRgba32Bytes(0);
     }
+    EngineLog::logger->info("  every mip of every texture: {:.2f} MiB, {:.2f} MiB as RGBA32",
+                            static_cast<double>(textureBytes) / (1024.0 * 1024.0),
+                            static_cast<double>(rgba32Bytes) / (1024.0 * 1024.0));
 }
 
 void GNVEngine::createUniformBuffers()
 {
     uniformBuffers.clear();
-    uniformBuffersMemory.clear();
     uniformBuffersMapped.clear();
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         vk::DeviceSize bufferSize = sizeof(UniformBufferObject);
-        vk::raii::Buffer buffer({});
-        vk::raii::DeviceMemory bufferMem({});
+        GpuBuffer buffer({});
         createBuffer(bufferSize, vk::BufferUsageFlagBits::eUniformBuffer,
-                     vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, buffer,
-                     bufferMem);
+                     VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT, buffer);
         uniformBuffers.emplace_back(std::move(buffer));
-        uniformBuffersMemory.emplace_back(std::move(bufferMem));
-        uniformBuffersMapped.emplace_back(uniformBuffersMemory[i].mapMemory(0, bufferSize));
+        uniformBuffersMapped.emplace_back(uniformBuffers[i].getMapped());
     }
 }
 
 void GNVEngine::createDescriptorSets()
 {
-    uint32_t textureCount = static_cast<uint32_t>(textureManager.size());
-
-    std::vector<uint32_t> variableCounts(MAX_FRAMES_IN_FLIGHT, MAX_TEXTURES);
+    std::vector<uint32_t> variableCounts(MAX_FRAMES_IN_FLIGHT, bindlessTextures.getCapacity());
     vk::DescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{};
     variableCountInfo.setDescriptorSetCount(static_cast<uint32_t>(variableCounts.size()))
         .setPDescriptorCounts(variableCounts.data());
@@ -1359,6 +3022,14 @@ void GNVEngine::createDescriptorSets()
 
     descriptorSets = device.allocateDescriptorSets(allocInfo);
 
+    // Written by createObjectBuffers() once the meshes are known
+    std::vector<vk::DescriptorSetLayout> cullLayouts(MAX_FRAMES_IN_FLIGHT, *cullDescriptorSetLayout);
+    vk::DescriptorSetAllocateInfo cullAllocInfo{};
+    cullAllocInfo.setDescriptorPool(*descriptorPool)
+        .setDescriptorSetCount(static_cast<uint32_t>(cullLayouts.size()))
+        .setPSetLayouts(cullLayouts.data());
+    cullDescriptorSets = device.allocateDescriptorSets(cullAllocInfo);
+
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         std::vector<vk::WriteDescriptorSet> writes{};
 
@@ -1374,49 +3045,13 @@ void GNVEngine::createDescriptorSets()
             .setPBufferInfo(&bufferInfo);
         writes.push_back(uboWrite);
 
-        // Texture array
-        std::vector<vk::DescriptorImageInfo> imageInfos;
-        for (auto& texture : textureManager) {
-            vk::DescriptorImageInfo info{};
-            info.setSampler(*textureSampler)
-                .setImageView(texture.imageView)
-                .setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
-            imageInfos.push_back(info);
-        }
-
-        vk::WriteDescriptorSet textureWrite{};
-        if (!imageInfos.empty()) {
-            textureWrite.setDstSet(*descriptorSets[i])
-                .setDstBinding(1)
-                .setDescriptorCount(static_cast<uint32_t>(imageInfos.size()))
-                .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
-                .setPImageInfo(imageInfos.data());
-            writes.push_back(textureWrite);
-        }
+        // Textures are written by bindlessTextures as they are created
 
         // std::array<vk::WriteDescriptorSet, 2> writes = { uboWrite, textureWrite };
         device.updateDescriptorSets(writes, {});
     }
 }
 
-uint32_t GNVEngine::addTextureToBindless(vk::raii::DescriptorSet& descriptorSet, Texture& tex, uint32_t slot)
-{
-    EngineLog::logger->trace("Adding texture to slot {}", slot);
-    vk::DescriptorImageInfo info{};
-    info.setSampler(*textureSampler)
-        .setImageView(tex.imageView)
-        .setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
-    vk::WriteDescriptorSet write{};
-    write.setDstSet(descriptorSet)
-        .setDstBinding(1)
-        .setDstArrayElement(slot)
-        .setDescriptorCount(1)
-        .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
-        .setPImageInfo(&info);
-    device.updateDescriptorSets(write, {});
-    return slot;
-}
-
 void GNVEngine::updateUniformBuffer(uint32_t currentImage)
 {
     static auto startTime = std::chrono::high_resolution_clock::now();
@@ -1444,6 +3079,83 @@ void GNVEngine::updateUniformBuffer(uint32_t currentImage)
     ubo.proj[1][1] *= -1;
 
     memcpy(uniformBuffersMapped[currentImage], &ubo, sizeof(ubo));
+    uniformBuffers[currentImage].flush(0, sizeof(ubo));
+}
+
+void GNVEngine::createFrameGraph()
+{
+    // ImGui goes first, so every later stage sees this frame's settings and camera. From there simulation and the
+    // camera run side by side, then transform upload, texture streaming and culling, and draw-list building once
+    // the CPU LODs are in. Recording and submission wait for all of it.
+    using TaskId = TaskGraph::TaskId;
+    TaskId input = frameGraph.add(
+        "input",
+        [this] {
+            if (!settings.headless)
+                newImGuiFrame();
+        },
+        {}, TaskAffinity::Main);
+    // Kept off the workers, it may wait on a physics step that needs one
+    TaskId simulation = frameGraph.add("simulation", [this] { updateScene(); }, { input }, TaskAffinity::Main);
+    TaskId camera = frameGraph.add("camera", [this] { updateUniformBuffer(frameIndex); }, { input });
+    TaskId transforms = frameGraph.add("transforms", [this] { uploadObjectTransforms(); }, { simulation });
+    TaskId streaming = frameGraph.add("streaming", [this] { updateTextureStreaming(); }, { simulation, camera });
+    TaskId culling = frameGraph.add("culling", [this] { cullObjects(); }, { simulation, camera });
+    TaskId lods = frameGraph.addParallelFor(
+        "lod selection", [this] { return settings.gpuCulling ? size_t(0) : visibleObjects.size(); },
+        LOD_SELECTION_GRAIN, [this](size_t begin, size_t end) { selectLods(begin, end); }, { culling });
+    TaskId drawList = frameGraph.add(
+        "draw list",
+        [this] {
+            if (!settings.gpuCulling)
+                buildInstanceGroups();
+            // Transforms and instances go to the device together
+            frameAllocator.flush();
+        },
+        { transforms, lods });
+    frameGraph.add("recording", [this] { recordFrame(); }, { streaming, drawList }, TaskAffinity::Main);
+}
+
+void GNVEngine::recordFrame()
+{
+    bindlessTextures.flush(frameIndex, *descriptorSets[frameIndex]);
+    // Anything queued since the last frame is submitted ahead of it, so this frame already sees the results
+    uploads.flush();
+
+    // The fence has signaled, so everything recorded for this slot can go at once
+    FrameCommandPools& pools = framePools[frameIndex];
+    pools.primary.reset();
+    for (auto& pool : pools.workers)
+        pool.reset();
+    recordCommandBuffer(frameImageIndex);
+}
+
+void GNVEngine::cullObjects()
+{
+    if (settings.gpuCulling)
+        return;
+    // The frustum against each object's world-space bounds, walked down the scene BVH so culled subtrees are skipped
+    // whole. The cull shader tests the same bounds object by object.
+    visibleObjects.clear();
+    cpuCullStats = sceneBvh.cull(Frustum::fromMatrix(ubo.proj * ubo.view * ubo.model), visibleObjects);
+    drawnTriangles = 0;
+}
+
+void GNVEngine::selectLods(size_t begin, size_t end)
+{
+    // Same selection as the cull shader, objects out of view keep their LOD
+    glm::vec3 cameraPosition = glm::vec3(glm::inverse(ubo.view * ubo.model) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    float errorScale = getLodErrorScale(ubo.proj, static_cast<float>(swapChainExtent.height));
+    uint64_t triangles = 0;
+    for (size_t v = begin; v < end; ++v) {
+        uint32_t i = visibleObjects[v];
+        const Mesh& mesh = meshManager[objectMeshes[i]];
+        const ObjectTransform& transform = objectTransforms[i];
+        objectLods[i] = selectLod(mesh.lods, transform.getBounds(), cameraPosition, errorScale * transform.boundsMax.w,
+                                  settings.lodThreshold, LOD_HYSTERESIS, objectLods[i]);
+        triangles += mesh.lods[objectLods[i]].indexCount / 3;
+    }
+    std::atomic_ref<uint64_t>(drawnTriangles).fetch_add(triangles);
 }
 
 void GNVEngine::newImGuiFrame()
@@ -1454,10 +3166,8 @@ void GNVEngine::newImGuiFrame()
     ImGui::Begin(ENGINE_NAME.c_str());
 
     if (ImGui::CollapsingHeader("Log")) {
-        if (EngineLog::imgui_sink != nullptr) {
-            for (auto& entry : EngineLog::imgui_sink->buffer)
-                ImGui::TextColored(entry.color, "%s", entry.msg.c_str());
-        }
+        if (EngineLog::imgui_sink != nullptr)
+            EngineLog::imgui_sink->draw();
     }
 
     if (ImGui::CollapsingHeader("Camera")) {
@@ -1472,17 +3182,141 @@ void GNVEngine::newImGuiFrame()
         }
     }
 
+    if (ImGui::CollapsingHeader("Culling")) {
+        ImGui::Checkbox("GPU culling", &settings.gpuCulling);
+        ImGui::Text("Visible: %u / %u", visibleCount, objectCount);
+        ImGui::Text("Draws: %u (%u meshlets in the scene)", drawCount, meshletCount);
+        ImGui::Text("Indirect draws: %zu", settings.gpuCulling ? drawBuckets.size() : size_t(0));
+        ImGui::Text("Recording threads: %u", lastRecorderCount);
+        if (!settings.gpuCulling) {
+            ImGui::Text("CPU BVH: %zu nodes, %u visited", sceneBvh.getNodeCount(), cpuCullStats.nodesVisited);
+            ImGui::Text("Tested %u, visible %u, culled %u in %.1f us", cpuCullStats.tested, cpuCullStats.visible,
+                        cpuCullStats.culled, cpuCullStats.micros);
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Frame Graph")) {
+        // The last frame's, apart from the first stage, which is the one drawing this
+        ImGui::Text("%zu stages in %.2f ms on %zu workers", frameGraph.getTaskCount(), frameGraph.getRunMs(),
+                    static_cast<size_t>(threadPool.get_thread_count()));
+        for (TaskGraph::TaskId t = 1; t < frameGraph.getTaskCount(); ++t) {
+            ImGui::Text("%-14s %6.3f - %6.3f ms", frameGraph.getName(t).c_str(), frameGraph.getStartMs(t),
+                        frameGraph.getEndMs(t));
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Scene")) {
+        ImGui::Text("Nodes: %zu, objects: %u", scene.getNodeCount(), objectCount);
+        ImGui::Text("Moved %u nodes in %.1f us", simulationStats.changedNodes, simulationStats.updateMicros);
+        if (settings.threadedSimulation)
+            ImGui::Text("On the simulation thread, tick %llu", static_cast<unsigned long long>(simulationTick));
+    }
+
+    // The body count never changes once the bodies are in, the rest comes from the last update
+    if (physics && ImGui::CollapsingHeader("Physics")) {
+        ImGui::Text("Bodies: %u, active: %u", physics->getBodyCount(), simulationStats.physicsActiveBodies);
+        ImGui::Text("Steps last update: %u, took %.2f ms", simulationStats.physicsSteps,
+                    simulationStats.physicsStepMs);
+    }
+
+    if (ImGui::CollapsingHeader("Level of Detail")) {
+        ImGui::SliderFloat("Error threshold (px)", &settings.lodThreshold, 0.0f, 16.0f);
+        ImGui::Text("Triangles drawn: %llu / %llu", static_cast<unsigned long long>(drawnTriangles),
+                    static_cast<unsigned long long>(sceneTriangles));
+    }
+
+    if (ImGui::CollapsingHeader("Texture Streaming")) {
+        int budgetMiB = static_cast<int>(settings.textureBudgetMiB);
+        if (ImGui::SliderInt("Budget (MiB, 0 = unlimited)", &budgetMiB, 0, 4096))
+            settings.textureBudgetMiB = static_cast<uint32_t>(budgetMiB);
+        auto toMiB = [](uint64_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+        uint64_t residentBytes = 0;
+        uint64_t residentRgba32Bytes = 0;
+        uint64_t allBytes = 0;
+        uint64_t allRgba32Bytes = 0;
+        for (const Texture& texture : textureManager) {
+            residentBytes += texture.getBytes(texture.baseLevel);
+            residentRgba32Bytes += texture.getRgba32Bytes(texture.baseLevel);
+            allBytes += texture.getBytes(0);
+            allRgba32Bytes += texture.getRgba32Bytes(0);
+        }
+        ImGui::Text("Resident: %.2f MiB (%.2f MiB as RGBA32), %zu changes in flight", toMiB(residentBytes),
+                    toMiB(residentRgba32Bytes), textureStreamer.getPendingCount());
+        ImGui::Text("Every mip: %.2f MiB (%.2f MiB as RGBA32)", toMiB(allBytes), toMiB(allRgba32Bytes));
+        ImGui::Text("Bindless slots: %u / %u, %zu samplers", bindlessTextures.getUsedCount(),
+                    bindlessTextures.getCapacity(), samplers.getCount());
+        for (uint32_t t = 0; t < textureManager.size(); ++t) {
+            const Texture& texture = textureManager[t];
+            ImGui::Text("Texture %u: %ux%u %s, levels %u-%u resident, level %u wanted", t, texture.width,
+                        texture.height, vk::to_string(texture.imageFormat).c_str(), texture.baseLevel,
+                        texture.mipLevels - 1, textureStreamer.getWantedLevel(t));
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Memory")) {
+        auto toMiB = [](VkDeviceSize bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+
+        const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+        vmaGetMemoryProperties(*allocator, &memoryProperties);
+        std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets{};
+        vmaGetHeapBudgets(*allocator, budgets.data());
+
+        VmaStatistics total{};
+        for (uint32_t heap = 0; heap < memoryProperties->memoryHeapCount; ++heap) {
+            total.allocationCount += budgets[heap].statistics.allocationCount;
+            total.allocationBytes += budgets[heap].statistics.allocationBytes;
+            total.blockCount += budgets[heap].statistics.blockCount;
+            total.blockBytes += budgets[heap].statistics.blockBytes;
+        }
+        ImGui::Text("Allocations: %u (%.2f MiB)", total.allocationCount, toMiB(total.allocationBytes));
+        ImGui::Text("Device memory blocks: %u (%.2f MiB)", total.blockCount, toMiB(total.blockBytes));
+        for (uint32_t heap = 0; heap < memoryProperties->memoryHeapCount; ++heap) {
+            ImGui::Text("Heap %u: %.2f / %.2f MiB", heap, toMiB(budgets[heap].usage), toMiB(budgets[heap].budget));
+        }
+
+        GeometryArena::Stats geometryStats = geometry.getStats();
+        ImGui::Text("Geometry arena: %u meshes in %u pages", geometryStats.allocationCount, geometryStats.pageCount);
+        ImGui::Text("  Vertices: %.2f / %.2f MiB (largest free range %.2f MiB)",
+                    toMiB(geometryStats.vertexBytes - geometryStats.vertexFreeBytes), toMiB(geometryStats.vertexBytes),
+                    toMiB(geometryStats.largestFreeVertexRange));
+        ImGui::Text("  Indices: %.2f / %.2f MiB", toMiB(geometryStats.indexBytes - geometryStats.indexFreeBytes),
+                    toMiB(geometryStats.indexBytes));
+        // Streaming replaces texture images all the time, which leaves holes in the blocks they're sub-allocated from
+        if (ImGui::Button("Defragment textures"))
+            textureDefragmentRequested = true;
+    }
+
     if (ImGui::CollapsingHeader("Mesh Data")) {
         for (size_t m = 0; m < meshManager.size(); ++m) {
             auto& mesh = meshManager[m];
             if (ImGui::TreeNode((void*)(intptr_t)m, "Mesh %zu", m)) {
 
                 ImGui::Text("Texture index: %zu", mesh.textureIndex);
+                ImGui::Text("Uploaded: %s", uploads.isComplete(mesh.uploadHandle) ? "yes" : "no");
+                ImGui::Text("Arena page %u, first index %u, vertex offset %d", mesh.geometry.page,
+                            mesh.geometry.firstIndex, mesh.geometry.firstVertex);
 
                 // Vertices
+                ImGui::Text("Vertex format: %s, %u bytes per vertex",
+                            mesh.vertexFormat == VertexFormat::Packed ? "packed" : "float",
+                            getVertexStride(mesh.vertexFormat));
+                ImGui::Text("Indices: %u x %s", mesh.indexCount,
+                            mesh.indexType == vk::IndexType::eUint16 ? "uint16" : "uint32");
+                // Only the CPU path knows which LOD each object was drawn at
+                std::vector<uint32_t> drawnObjects(mesh.lods.size(), 0);
+                if (!settings.gpuCulling) {
+                    for (uint32_t i : visibleObjects) {
+                        if (objectMeshes[i] == m)
+                            drawnObjects[objectLods[i]]++;
+                    }
+                }
+                for (size_t l = 0; l < mesh.lods.size(); ++l) {
+                    ImGui::Text("LOD %zu: %u triangles, error %.5f, drawn by %u objects", l,
+                                mesh.lods[l].indexCount / 3, mesh.lods[l].error, drawnObjects[l]);
+                }
                 if (ImGui::TreeNode("Vertices")) {
-                    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
-                        auto& v = mesh.vertices[i];
+                    for (size_t i = 0; i < mesh.vertexCount; ++i) {
+                        Vertex v = mesh.getVertex(i);
                         ImGui::Text("[%zu] pos=(%.3f, %.3f, %.3f) uv=(%.3f, %.3f)", i, v.pos.x, v.pos.y, v.pos.z,
                                     v.texCoord.x, v.texCoord.y);
                     }
@@ -1491,10 +3325,10 @@ void GNVEngine::newImGuiFrame()
 
                 // Indices
                 if (ImGui::TreeNode("Indices")) {
-                    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
-                        if (i + 2 < mesh.indices.size()) {
-                            ImGui::Text("[%zu] %u, %u, %u", i / 3, mesh.indices[i], mesh.indices[i + 1],
-                                        mesh.indices[i + 2]);
+                    for (size_t i = 0; i < mesh.indexCount; i += 3) {
+                        if (i + 2 < mesh.indexCount) {
+                            ImGui::Text("[%zu] %u, %u, %u", i / 3, mesh.getIndex(i), mesh.getIndex(i + 1),
+                                        mesh.getIndex(i + 2));
                         }
                     }
                     ImGui::TreePop();
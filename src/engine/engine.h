@@ -4,12 +4,23 @@
 #include <algorithm>
 #include <array>
 #include <assert.h>
+#include <atomic>
+#include <cmath>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
 // Vulkan
@@ -52,6 +63,9 @@
 #include <fastgltf/tools.hpp>
 #include <fastgltf/types.hpp>
 
+// meshoptimizer
+#include <meshoptimizer.h>
+
 // thread-pool
 #include <BS_thread_pool.hpp>
 
@@ -63,15 +77,67 @@
 // cereal
 #include <cereal/archives/binary.hpp>
 
+// GNVE
+#include <bindless_table.h>
+#include <collision_shapes.h>
+#include <cooked_model.h>
+#include <culling.h>
+#include <frame_allocator.h>
+#include <frame_benchmark.h>
+#include <geometry_arena.h>
+#include <gpu_memory.h>
+#include <mesh_lod.h>
+#include <meshlet.h>
+#include <physics.h>
+#include <pipeline_cache.h>
+#include <sampler_cache.h>
+#include <scene.h>
+#include <scene_bvh.h>
+#include <snapshot_mailbox.h>
+#include <task_graph.h>
+#include <texture_streamer.h>
+#include <upload_scheduler.h>
+
 constexpr uint32_t WIDTH = 1920;
 constexpr uint32_t HEIGHT = 1080;
 constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-constexpr uint32_t MAX_TEXTURES = 16;
+// Upper bound on the bindless texture array, the device's descriptor limits can make it smaller
+constexpr uint32_t MAX_TEXTURES = 65536;
+// Size of each geometry arena page; meshes that don't fit in a page get one of their own size
+constexpr vk::DeviceSize GEOMETRY_VERTEX_PAGE_SIZE = 64ull * 1024 * 1024;
+constexpr vk::DeviceSize GEOMETRY_INDEX_PAGE_SIZE = 32ull * 1024 * 1024;
+// Images at least this large get their own VkDeviceMemory instead of being sub-allocated
+constexpr vk::DeviceSize DEDICATED_IMAGE_THRESHOLD = 16ull * 1024 * 1024;
+constexpr vk::DeviceSize UPLOAD_RING_SIZE = 64ull * 1024 * 1024;
+// Per frame in flight, grown to fit every object's transform when there are more
+constexpr vk::DeviceSize FRAME_ALLOCATOR_SIZE = 4ull * 1024 * 1024;
 const std::string APP_NAME = "GNVEApp";
 const std::string ENGINE_NAME = "GNVEngine";
 // const std::string MODEL_PATH = "assets/models/square.glb";
 const std::string MODEL_PATH = "assets/models/viking_room.glb";
 const std::string SHADER_PATH = "shaders/shader.spv";
+const std::string CULL_SHADER_PATH = "shaders/cull.spv";
+const std::string PIPELINE_CACHE_DIR = "cache";
+const std::string COOKED_MODEL_DIR = "cache/models";
+const std::string COLLISION_SHAPE_DIR = "cache/collision";
+constexpr uint32_t CULL_WORKGROUP_SIZE = 64;
+constexpr uint32_t CULL_STORAGE_BUFFER_COUNT = 9;
+// Share of the LOD threshold a coarser level's error has to drop below before it replaces the current one. Must match
+// LOD_HYSTERESIS in shaders/cull.slang.
+constexpr float LOD_HYSTERESIS = 0.25f;
+// Texture residency changes started per frame, each one recreates an image and uploads its mips
+constexpr size_t TEXTURE_STREAMING_CHANGES_PER_FRAME = 4;
+// Keeps a mesh's screen size finite with the camera inside its bounds
+constexpr float TEXTURE_STREAMING_MIN_DISTANCE = 1e-4f;
+// CPU-driven frames split their draws across secondary command buffers once each worker gets at least this many
+constexpr size_t MIN_DRAWS_PER_RECORDER = 1024;
+// CPU LOD selection is split across the workers in runs of at least this many visible objects
+constexpr size_t LOD_SELECTION_GRAIN = 2048;
+// Physics steps at this fixed rate, and catches up on at most this many steps a frame
+constexpr float PHYSICS_TIMESTEP = 1.0f / 60.0f;
+constexpr uint32_t PHYSICS_MAX_STEPS_PER_FRAME = 4;
+// Vertex input binding of the per-instance object indices, after the vertices at 0
+constexpr uint32_t INSTANCE_BINDING = 1;
 
 const std::vector<char const*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
 
@@ -99,6 +165,59 @@ struct Vertex {
     bool operator==(const Vertex& other) const { return pos == other.pos && texCoord == other.texCoord; }
 };
 
+// 16-bit unorm position and UV, relative to a per-mesh range: value = offset + stored * scale. 12 bytes instead of 20.
+struct PackedVertex {
+    uint16_t pos[4];
+    uint16_t texCoord[2];
+
+    static vk::VertexInputBindingDescription getBindingDescription()
+    {
+        return { 0, sizeof(PackedVertex), vk::VertexInputRate::eVertex };
+    }
+
+    static std::array<vk::VertexInputAttributeDescription, 2> getAttributeDescriptions()
+    {
+        return { vk::VertexInputAttributeDescription(0, 0, vk::Format::eR16G16B16A16Unorm,
+                                                     offsetof(PackedVertex, pos)),
+                 vk::VertexInputAttributeDescription(1, 0, vk::Format::eR16G16Unorm,
+                                                     offsetof(PackedVertex, texCoord)) };
+    }
+
+    static PackedVertex pack(const Vertex& vertex, const glm::vec3& positionOffset, const glm::vec3& positionScale,
+                             const glm::vec4& uvTransform)
+    {
+        auto quantize = [](float value, float offset, float scale) {
+            float normalized = scale > 0.0f ? std::clamp((value - offset) / scale, 0.0f, 1.0f) : 0.0f;
+            return static_cast<uint16_t>(std::lround(normalized * 65535.0f));
+        };
+        PackedVertex packed{};
+        for (int i = 0; i < 3; ++i)
+            packed.pos[i] = quantize(vertex.pos[i], positionOffset[i], positionScale[i]);
+        for (int i = 0; i < 2; ++i)
+            packed.texCoord[i] = quantize(vertex.texCoord[i], uvTransform[i], uvTransform[i + 2]);
+        return packed;
+    }
+
+    [[nodiscard]] Vertex unpack(const glm::vec3& positionOffset, const glm::vec3& positionScale,
+                                const glm::vec4& uvTransform) const
+    {
+        glm::vec3 position(pos[0], pos[1], pos[2]);
+        glm::vec2 uv(texCoord[0], texCoord[1]);
+        return { positionOffset + position / 65535.0f * positionScale,
+                 glm::vec2(uvTransform) + uv / 65535.0f * glm::vec2(uvTransform.z, uvTransform.w) };
+    }
+};
+static_assert(sizeof(PackedVertex) == 12);
+
+// Indexes graphicsPipelines, one pipeline per vertex input layout
+enum class VertexFormat : uint32_t { Float, Packed };
+constexpr size_t VERTEX_FORMAT_COUNT = 2;
+
+constexpr uint32_t getVertexStride(VertexFormat format)
+{
+    return format == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
 template <> struct std::hash<Vertex> {
     size_t operator()(Vertex const& vertex) const noexcept
     {
@@ -112,6 +231,93 @@ struct UniformBufferObject {
     alignas(16) glm::mat4 proj;
 };
 
+// One per object, read by the cull shader and by the vertex shader through the object index of its instance. std430
+// layout, must match ObjectData in shaders/*.slang.
+struct ObjectData {
+    glm::vec4 boundsMin;
+    glm::vec4 boundsMax;
+    // Vertex dequantization, identity for float vertices: position = offset + stored * scale, and likewise for the
+    // UV with offset in xy and scale in zw
+    glm::vec4 positionOffset;
+    glm::vec4 positionScale;
+    glm::vec4 uvTransform;
+    uint32_t indexCount;
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+    uint32_t textureIndex;
+    // Draws that can share one drawIndexedIndirectCount (same arena page, vertex format, index type and cull mode),
+    // and where their commands start
+    uint32_t bucket;
+    uint32_t commandBase;
+    // The mesh's run of LodData in the LOD buffer
+    uint32_t lodBase;
+    uint32_t lodCount;
+    // Nonzero for double-sided materials, whose meshlets the cluster pass doesn't cone cull
+    uint32_t doubleSided;
+    uint32_t padding[3];
+};
+static_assert(sizeof(ObjectData) == 128);
+
+// Where an object is this frame, indexed like ObjectData and copied into frameAllocator every frame. std430 layout,
+// must match ObjectTransform in shaders/*.slang.
+struct ObjectTransform {
+    glm::mat4 model{ 1.0f };
+    // The mesh's bounds moved by model. The smallest and largest scale model applies along an axis go in the w
+    // components, LOD errors and meshlet spheres grow by the largest.
+    glm::vec4 boundsMin;
+    glm::vec4 boundsMax;
+
+    static ObjectTransform of(const Aabb& bounds, const glm::mat4& model);
+    // Scale, rotation and translation blended apart, a blend of the matrices would shear objects that turn
+    static ObjectTransform interpolate(const Aabb& bounds, const ObjectTransform& from, const ObjectTransform& to,
+                                       float alpha);
+    [[nodiscard]] Aabb getBounds() const { return Aabb{ glm::vec3(boundsMin), glm::vec3(boundsMax) }; }
+};
+static_assert(sizeof(ObjectTransform) == 96);
+
+// One per LOD of every mesh, read by the cull shader. firstIndex is absolute, ready for the draw command, and so is
+// meshletBase into the meshlet buffer. Levels without meshlets are drawn whole.
+struct LodData {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;
+    uint32_t meshletBase;
+    uint32_t meshletCount;
+};
+static_assert(sizeof(LodData) == 20);
+
+// One per meshlet of every mesh, read by the cluster cull pass. Bounds are in object space, firstIndex is absolute.
+struct MeshletData {
+    // Center in xyz, radius in w
+    glm::vec4 sphere;
+    // Apex in xyz, cutoff in w
+    glm::vec4 cone;
+    glm::vec4 coneAxis;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    uint32_t padding[2];
+};
+static_assert(sizeof(MeshletData) == 64);
+
+// Queued by the object pass for each visible object whose LOD has meshlets, culled by one cluster pass workgroup.
+// GPU only, must match ClusterWork in shaders/cull.slang.
+struct ClusterWork {
+    uint32_t objectIndex;
+    uint32_t meshletBase;
+    uint32_t meshletCount;
+};
+
+struct CullPushConstants {
+    glm::vec4 planes[6];
+    // Object space, xyz
+    glm::vec4 cameraPosition;
+    uint32_t objectCount;
+    // The drawn triangle and visible object counters follow the per-bucket draw counts
+    uint32_t bucketCount;
+    float lodErrorScale;
+    float lodThreshold;
+};
+
 struct CameraControls {
     glm::vec3 position = { 2.0f, 2.0f, 2.0f };
     glm::vec3 target = { 0.0f, 0.0f, 0.0f };
@@ -119,46 +325,203 @@ struct CameraControls {
     float fov = 45.0f;
 };
 
+// What one update of the scene did, shown in the UI
+struct SimulationStats {
+    uint32_t changedNodes = 0;
+    double updateMicros = 0.0;
+    uint32_t physicsActiveBodies = 0;
+    uint32_t physicsSteps = 0;
+    double physicsStepMs = 0.0;
+};
+
+// Everything the renderer needs from a tick of the simulation thread, copied out so it never touches the scene or
+// the physics world. Transforms are whole rather than the objects that moved, so a snapshot the renderer skipped is
+// made up for by the next.
+struct RenderSnapshot {
+    uint64_t tick = 0;
+    // When the tick started, what the renderer interpolates between snapshots by
+    std::chrono::high_resolution_clock::time_point time{};
+    // Bumped by every tick that moved an object. Transforms are only copied into a slot that is behind, and only
+    // compared by a renderer that is.
+    uint64_t transformsVersion = 0;
+    std::vector<ObjectTransform> objectTransforms;
+    SimulationStats stats;
+};
+
+struct EngineSettings {
+    // Render into engine-owned offscreen images instead of a GLFW swapchain (no window, no ImGui).
+    bool headless = false;
+    // When non-zero, draw this many frames, write a timing report and exit.
+    uint32_t benchmarkFrames = 0;
+    CameraPath cameraPath = CameraPath::Static;
+    // Cull and compact draws in a compute pass and draw them with drawIndexedIndirectCount. Otherwise every mesh is
+    // drawn from the CPU.
+    bool gpuCulling = true;
+    // Cook models with 16-bit positions and UVs instead of 32-bit floats
+    bool quantizeVertices = true;
+    // Projected error in pixels a LOD may have before a finer one is drawn, 0 always draws full resolution
+    float lodThreshold = 1.0f;
+    // Device memory streamed texture mips may take up, 0 is unlimited. Mip tails are always resident.
+    uint32_t textureBudgetMiB = 256;
+    // Copies of the model laid out side by side on a square grid, each under a root node of its own
+    uint32_t modelCopies = 1;
+    // More copies of the model, each a dynamic body dropped onto the grid
+    uint32_t physicsBodies = 0;
+    // Run the scene and physics on a thread of their own, handing the renderer a snapshot per tick
+    bool threadedSimulation = false;
+    std::string reportPath = "benchmark.json";
+};
+
+// A Basis Universal transcode target and the formats its blocks are sampled as
+struct TranscodeTarget {
+    ktx_transcode_fmt_e format = KTX_TTF_RGBA32;
+    vk::Format unorm = vk::Format::eR8G8B8A8Unorm;
+    vk::Format srgb = vk::Format::eR8G8B8A8Srgb;
+};
+
+// The best target the device can sample, for Basis textures without and with alpha
+struct TranscodeTargets {
+    TranscodeTarget opaque;
+    TranscodeTarget alpha;
+};
+
+// A KTX2 texture loaded and, if needed, transcoded on a worker thread, waiting for its GPU upload.
+// Textures keep it afterwards to stream their mips from.
+struct DecodedTexture {
+    struct KtxDeleter {
+        void operator()(ktxTexture2* texture) const { ktxTexture2_Destroy(texture); }
+    };
+    std::unique_ptr<ktxTexture2, KtxDeleter> ktx;
+    vk::Format format = vk::Format::eUndefined;
+};
+
 struct Texture {
-    vk::raii::Image image = nullptr;
-    vk::raii::DeviceMemory imageMemory = nullptr;
+    // Holds the resident mips only, level 0 of image is baseLevel of the texture
+    GpuImage image = nullptr;
     vk::raii::ImageView imageView = nullptr;
     vk::Format imageFormat = vk::Format::eUndefined;
     uint32_t width;
     uint32_t height;
     uint32_t mipLevels;
+    uint32_t baseLevel = 0;
+    // Index into the bindless texture array, what ObjectData::textureIndex holds
+    uint32_t slot = 0;
+    // Owned by the engine's SamplerCache
+    vk::Sampler sampler = nullptr;
+    UploadHandle uploadHandle = 0;
+    DecodedTexture source;
+
+    // A residency change being uploaded, it replaces image once the upload completes
+    struct PendingLevels {
+        GpuImage image = nullptr;
+        vk::raii::ImageView imageView = nullptr;
+        uint32_t baseLevel = 0;
+        UploadHandle uploadHandle = 0;
+    };
+    std::optional<PendingLevels> pending;
+
+    // Bytes of levels [level, mipLevels) as uploaded, and as they would be uncompressed
+    [[nodiscard]] uint64_t getBytes(uint32_t level) const
+    {
+        uint64_t bytes = 0;
+        for (; level < mipLevels; ++level)
+            bytes += ktxTexture_GetImageSize(ktxTexture(source.ktx.get()), level);
+        return bytes;
+    }
+    [[nodiscard]] uint64_t getRgba32Bytes(uint32_t level) const
+    {
+        uint64_t bytes = 0;
+        for (; level < mipLevels; ++level)
+            bytes += uint64_t{ std::max(width >> level, 1u) } * std::max(height >> level, 1u) * 4;
+        return bytes;
+    }
 };
 
 struct Mesh {
-    std::vector<Vertex> vertices;
-    std::vector<uint32_t> indices;
-    vk::raii::Buffer vertexBuffer = nullptr;
-    vk::raii::DeviceMemory vertexBufferMemory = nullptr;
-    vk::raii::Buffer indexBuffer = nullptr;
-    vk::raii::DeviceMemory indexBufferMemory = nullptr;
-    size_t textureIndex;
+    // Views into the cooked model the mesh was loaded from, vertexData holds vertexCount vertices of vertexFormat and
+    // indexData indexCount indices of indexType
+    std::span<const std::byte> vertexData;
+    uint32_t vertexCount = 0;
+    VertexFormat vertexFormat = VertexFormat::Float;
+    std::span<const std::byte> indexData;
+    uint32_t indexCount = 0;
+    vk::IndexType indexType = vk::IndexType::eUint32;
+    // Dequantization for packed vertices, see ObjectData
+    glm::vec3 positionOffset{ 0.0f };
+    glm::vec3 positionScale{ 1.0f };
+    glm::vec4 uvTransform{ 0.0f, 0.0f, 1.0f, 1.0f };
+    // Index runs into indexData, level 0 first
+    std::vector<MeshLod> lods;
+    // View into the cooked model, indexed by the LODs
+    std::span<const CookedMeshlet> meshlets;
+    GeometryAllocation geometry{};
+    UploadHandle uploadHandle = 0;
+    size_t textureIndex = 0;
+    // Drawn without back-face culling
+    bool doubleSided = false;
+    Aabb bounds{};
+
+    [[nodiscard]] Vertex getVertex(size_t i) const
+    {
+        if (vertexFormat == VertexFormat::Float)
+            return reinterpret_cast<const Vertex*>(vertexData.data())[i];
+        return reinterpret_cast<const PackedVertex*>(vertexData.data())[i].unpack(positionOffset, positionScale,
+                                                                                 uvTransform);
+    }
+    [[nodiscard]] uint32_t getIndex(size_t i) const
+    {
+        if (indexType == vk::IndexType::eUint16)
+            return reinterpret_cast<const uint16_t*>(indexData.data())[i];
+        return reinterpret_cast<const uint32_t*>(indexData.data())[i];
+    }
 };
 
 class GNVEngine
 {
   public:
+    explicit GNVEngine(EngineSettings settings = {}) : settings(std::move(settings)) {}
+
     void run()
     {
         setup_logger();
-        initWindow();
+        if (!settings.headless)
+            initWindow();
         initVulkan();
         mainLoop();
         cleanup();
     }
 
   private:
+    EngineSettings settings;
+    // CPU-side work: asset loading, physics, and the stages of a frame. Command buffers are only recorded on the
+    // thread that owns their pool.
+    BS::thread_pool<> threadPool;
+    // Everything a frame does between acquiring its image and submitting, see createFrameGraph()
+    TaskGraph frameGraph{ threadPool };
+    uint32_t frameImageIndex = 0;
+
     UniformBufferObject ubo{};
     CameraControls camera{};
 
     std::vector<Texture> textureManager;
-    uint32_t maxLod = 0;
-    vk::raii::Sampler textureSampler = nullptr;
+    TranscodeTargets transcodeTargets{};
+    TextureStreamer textureStreamer;
+    // Objects in view this frame, whose textures are requested from textureStreamer
+    std::vector<uint32_t> streamingObjects;
+    // Replaced images, destroyed once the frames that could sample them are done
+    struct RetiredTexture {
+        GpuImage image = nullptr;
+        vk::raii::ImageView imageView = nullptr;
+        uint64_t frame = 0;
+    };
+    std::vector<RetiredTexture> retiredTextures;
+    // Set from the Memory panel, done at the start of the next frame when nothing is being recorded
+    bool textureDefragmentRequested = false;
+    SamplerCache samplers = nullptr;
+    BindlessTable bindlessTextures = nullptr;
     std::vector<Mesh> meshManager;
+    // Backs every mesh's vertex and index views, mapped from COOKED_MODEL_DIR when it was cooked before
+    CookedModel model = nullptr;
 
     ImGuiIO io;
 
@@ -171,36 +534,156 @@ class GNVEngine
     vk::raii::Device device = nullptr;
     uint32_t queueIndex = ~0;
     vk::raii::Queue queue = nullptr;
+    GpuAllocator allocator = nullptr;
+    PipelineCache pipelineCache = nullptr;
+    GeometryArena geometry = nullptr;
+    UploadScheduler uploads = nullptr;
     vk::raii::SwapchainKHR swapChain = nullptr;
     std::vector<vk::Image> swapChainImages;
     vk::SurfaceFormatKHR swapChainSurfaceFormat;
     vk::Extent2D swapChainExtent;
     std::vector<vk::raii::ImageView> swapChainImageViews;
 
+    // Headless render targets, one per frame in flight
+    std::vector<GpuImage> offscreenImages;
+    std::vector<vk::raii::ImageView> offscreenImageViews;
+
     vk::raii::DescriptorSetLayout descriptorSetLayout = nullptr;
     vk::raii::PipelineLayout pipelineLayout = nullptr;
-    vk::raii::Pipeline graphicsPipeline = nullptr;
+    std::array<vk::raii::Pipeline, VERTEX_FORMAT_COUNT> graphicsPipelines{ nullptr, nullptr };
 
-    vk::raii::Image depthImage = nullptr;
-    vk::raii::DeviceMemory depthImageMemory = nullptr;
+    GpuImage depthImage = nullptr;
     vk::raii::ImageView depthImageView = nullptr;
     vk::Format depthFormat = vk::Format::eUndefined;
 
-    std::vector<vk::raii::Buffer> uniformBuffers;
-    std::vector<vk::raii::DeviceMemory> uniformBuffersMemory;
+    std::vector<GpuBuffer> uniformBuffers;
     std::vector<void*> uniformBuffersMapped;
 
+    // The model's node hierarchy. Every mesh a node draws is an object, objectMeshes holds the mesh of each.
+    Scene scene;
+    std::vector<uint32_t> objectMeshes;
+    SimulationStats simulationStats{};
+    std::vector<uint32_t> movedObjects;
+    std::chrono::high_resolution_clock::time_point lastSceneUpdate{};
+    // The first copy of the model where the scene puts it, what copies and bodies are spaced by
+    Aabb modelBounds{};
+    // Only there when the scene has bodies, steps on threadPool
+    std::unique_ptr<PhysicsWorld> physics;
+    // Indexed by body, the scene node that follows it
+    std::vector<entt::entity> bodyNodes;
+    // Indexed like meshManager, cooked or loaded from COLLISION_SHAPE_DIR once there is a physics world
+    std::vector<MeshCollision> meshCollision;
+
+    // With threadedSimulation the scene, physics and simulationTransforms belong to simulationThread, which ticks at
+    // the physics rate and publishes into snapshots; the renderer takes the latest one each frame
+    SnapshotMailbox<RenderSnapshot> snapshots;
+    std::vector<ObjectTransform> simulationTransforms;
+    uint64_t simulationTick = 0;
+    // The renderer's two latest snapshots, and when they were simulated. Objects drawn between them are the ones in
+    // interpolatedObjects, the rest are the same in both.
+    std::vector<ObjectTransform> fromTransforms;
+    std::vector<ObjectTransform> toTransforms;
+    std::chrono::high_resolution_clock::time_point fromTime{};
+    std::chrono::high_resolution_clock::time_point toTime{};
+    uint64_t toVersion = 0;
+    std::vector<uint32_t> interpolatedObjects;
+    float interpolationAlpha = -1.0f;
+    std::atomic<bool> simulationFailed{ false };
+    std::jthread simulationThread;
+
+    // GPU-driven drawing: objectBuffer is indexed by object, the cull pass writes each frame's commands and per-bucket
+    // counts
+    struct DrawBucket {
+        uint32_t page;
+        VertexFormat format;
+        vk::IndexType indexType;
+        bool doubleSided;
+        uint32_t commandBase;
+        uint32_t capacity;
+    };
+    GpuBuffer objectBuffer = nullptr;
+    uint32_t objectCount = 0;
+    std::vector<DrawBucket> drawBuckets;
+    // Every object index in order, the instance buffer of the indirect draws, whose firstInstance is the object
+    GpuBuffer objectIndexBuffer = nullptr;
+    std::vector<GpuBuffer> drawCommandBuffers;
+    std::vector<GpuBuffer> drawCountBuffers;
+    uint32_t visibleCount = 0;
+    // LodData of every mesh, and the LOD each object was last drawn at, kept between frames for the hysteresis
+    GpuBuffer lodBuffer = nullptr;
+    GpuBuffer lodStateBuffer = nullptr;
+    // Objects whose LOD has meshlets are culled again per meshlet: the object pass queues them as cluster work,
+    // one workgroup each, and the cluster pass is dispatched indirectly over that queue
+    GpuBuffer meshletBuffer = nullptr;
+    uint32_t meshletCount = 0;
+    std::vector<GpuBuffer> clusterWorkBuffers;
+    std::vector<GpuBuffer> clusterDispatchBuffers;
+    uint32_t drawCount = 0;
+    uint64_t drawnTriangles = 0;
+    // Every object at LOD 0
+    uint64_t sceneTriangles = 0;
+    // Indexed by object, the vertex and cull shaders read this frame's copy
+    std::vector<ObjectTransform> objectTransforms;
+    FrameAllocator frameAllocator = nullptr;
+
+    // CPU-driven drawing: objects are culled against sceneBvh in updateUniformBuffer() and only visibleObjects drawn.
+    // Visible objects that draw the same mesh at the same LOD are one instanced draw, their object indices are
+    // written to frameAllocator at instanceOffset and each group's run of them is its instances.
+    struct InstanceGroup {
+        uint32_t mesh;
+        uint32_t lod;
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+    };
+    SceneBvh sceneBvh;
+    std::vector<uint32_t> visibleObjects;
+    std::vector<InstanceGroup> instanceGroups;
+    vk::DeviceSize instanceOffset = 0;
+    // The LOD each object was last drawn at, indexed by object
+    std::vector<uint32_t> objectLods;
+    CullStats cpuCullStats{};
+    vk::raii::DescriptorSetLayout cullDescriptorSetLayout = nullptr;
+    vk::raii::PipelineLayout cullPipelineLayout = nullptr;
+    vk::raii::Pipeline cullPipeline = nullptr;
+    vk::raii::Pipeline clusterCullPipeline = nullptr;
+
     vk::raii::DescriptorPool imGuidescriptorPool = nullptr;
     vk::raii::DescriptorPool descriptorPool = nullptr;
     std::vector<vk::raii::DescriptorSet> descriptorSets;
+    std::vector<vk::raii::DescriptorSet> cullDescriptorSets;
 
     vk::raii::CommandPool commandPool = nullptr;
+    // Everything recorded for a frame in flight comes out of its pools, which are reset together once the frame's
+    // fence has signaled
+    struct FrameCommandPools {
+        vk::raii::CommandPool primary = nullptr;
+        // One pool and secondary command buffer per recording worker, so workers never share a pool
+        std::vector<vk::raii::CommandPool> workers;
+        std::vector<vk::raii::CommandBuffer> secondaries;
+    };
+    std::vector<FrameCommandPools> framePools;
     std::vector<vk::raii::CommandBuffer> commandBuffers;
+    uint32_t lastRecorderCount = 1;
 
     std::vector<vk::raii::Semaphore> presentCompleteSemaphores;
     std::vector<vk::raii::Semaphore> renderFinishedSemaphores;
     std::vector<vk::raii::Fence> inFlightFences;
     uint32_t frameIndex = 0;
+    // Frames started so far, counts up from 1 with the first one
+    uint64_t frameNumber = 0;
+
+    struct PendingFrameTiming {
+        bool valid = false;
+        uint32_t frame = 0;
+        double frameMs = 0.0;
+        double cpuMs = 0.0;
+    };
+    FrameBenchmark benchmark;
+    vk::raii::QueryPool timestampQueryPool = nullptr;
+    float timestampPeriod = 0.0f;
+    std::array<PendingFrameTiming, MAX_FRAMES_IN_FLIGHT> pendingTimings{};
+    uint32_t benchmarkFrame = 0;
+    glm::vec3 cameraPathOrigin{};
 
     bool framebufferResized = false;
 
@@ -214,26 +697,45 @@ class GNVEngine
     vk::Format findSupportedFormat(const std::vector<vk::Format>& candidates, vk::ImageTiling tiling,
                                    vk::FormatFeatureFlags features) const;
     void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, vk::Format format, vk::ImageTiling tiling,
-                     vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::raii::Image& image,
-                     vk::raii::DeviceMemory& imageMemory);
-    vk::raii::ImageView createImageView(vk::raii::Image& image, vk::Format format, vk::ImageAspectFlags aspectFlags,
+                     vk::ImageUsageFlags usage, GpuImage& image);
+    vk::raii::ImageView createImageView(vk::Image image, vk::Format format, vk::ImageAspectFlags aspectFlags,
                                         uint32_t mipLevels);
-    void transitionImageLayout(const vk::raii::Image& image, vk::ImageLayout oldLayout, vk::ImageLayout newLayout,
-                               uint32_t mipLevels);
+    // Moves sub-allocated texture images together and points their bindless slots at the new ones
+    void defragmentTextures();
     std::unique_ptr<vk::raii::CommandBuffer> beginSingleTimeCommands();
     void endSingleTimeCommands(const vk::raii::CommandBuffer& commandBuffer) const;
-    void copyBufferToImage(const vk::raii::Buffer& buffer, vk::raii::Image& image, uint32_t width, uint32_t height);
     void loadModel();
+    CookedModel cookModel(const std::filesystem::path& path, const CookedModelSource& source,
+                          const std::filesystem::path& cookedPath);
     void createUniformBuffers();
     void createDescriptorSets();
     void updateUniformBuffer(uint32_t currentImage);
-    uint32_t addTextureToBindless(vk::raii::DescriptorSet& descriptorSet, Texture& tex, uint32_t slot);
-
-    void createVertexBuffer(Mesh& mesh);
-    void createIndexBuffer(Mesh& mesh);
-
-    size_t createTexture(const uint8_t* ktxData, size_t ktxSize);
-    void createTextureSampler();
+    void createFrameGraph();
+    void recordFrame();
+
+    void uploadMesh(Mesh& mesh);
+
+    // srgb picks the sRGB format of the transcode target, for color data, or the sRGB twin of a stored UNORM format
+    static DecodedTexture decodeTexture(const uint8_t* ktxData, size_t ktxSize, const TranscodeTargets& targets,
+                                        bool srgb);
+    // The sRGB format with the same layout as a UNORM one, the format itself when there is none
+    static vk::Format getSrgbFormat(vk::Format format);
+    void chooseTranscodeTargets();
+    size_t createTexture(DecodedTexture& decoded);
+    // Creates an image holding levels [baseLevel, mipLevels) of the texture and queues their upload
+    UploadHandle uploadTextureLevels(const Texture& texture, uint32_t baseLevel, GpuImage& image,
+                                     vk::raii::ImageView& imageView);
+    void updateTextureStreaming();
+    struct MeshOptimizeStats {
+        meshopt_VertexCacheStatistics before;
+        meshopt_VertexCacheStatistics after;
+        size_t verticesBefore;
+        size_t verticesAfter;
+    };
+    static MeshOptimizeStats optimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+    static Aabb decodePrimitive(const fastgltf::Asset& asset, const fastgltf::Primitive& primitive,
+                                std::span<Vertex> vertices, std::span<uint32_t> indices, uint32_t baseIndex);
+    void createBindlessTable();
 
     void setup_logger();
     void initImGui();
@@ -245,6 +747,11 @@ class GNVEngine
     void createSwapChain();
     void createImageViews();
     void createSyncObjects();
+    void createOffscreenTargets();
+    void createTimestampQueryPool();
+    void resolveFrameTiming(uint32_t slot);
+    void runBenchmark();
+    void applyCameraPath(uint32_t frame, uint32_t frameCount);
 
     void initWindow();
     static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
@@ -257,8 +764,33 @@ class GNVEngine
     void pickPhysicalDevice();
     void createLogicalDevice();
     void createGraphicsPipeline();
+    void createCullPipeline();
+    void createScene();
+    void createPhysics(std::span<const entt::entity> bodyRoots);
+    void cookCollisionShapes();
+    // Applies this frame's scene: the simulation thread's two latest snapshots interpolated a tick behind, or one
+    // simulation step taken right here
+    void updateScene();
+    // Advances physics and the scene by the time since the last call and writes the objects that moved into
+    // transforms, listing them in moved
+    SimulationStats simulateScene(std::span<ObjectTransform> transforms, std::vector<uint32_t>& moved);
+    void startSimulationThread();
+    void runSimulation(std::stop_token stop);
+    void createObjectBuffers();
+    void uploadObjectTransforms();
+    // CPU-driven frames only: frustum culling, then LOD selection over runs of the visible objects
+    void cullObjects();
+    void selectLods(size_t begin, size_t end);
+    void buildInstanceGroups();
+    void buildSceneBvh();
+    void recordCulling(const vk::raii::CommandBuffer& commandBuffer);
+    void recordMeshDraws(const vk::raii::CommandBuffer& commandBuffer, std::span<const InstanceGroup> groups) const;
+    void recordMeshDrawsParallel(const vk::raii::CommandBuffer& commandBuffer, uint32_t recorderCount);
     void createCommandPool();
-    uint32_t findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties);
+    void createAllocator();
+    void createPipelineCache();
+    void createUploadScheduler();
+    void createGeometryArena();
     void createCommandBuffers();
     void recordCommandBuffer(uint32_t imageIndex);
     void transition_image_layout(vk::Image image, vk::ImageLayout old_layout, vk::ImageLayout new_layout,
@@ -277,9 +809,8 @@ class GNVEngine
                                                           const vk::DebugUtilsMessengerCallbackDataEXT* pCallbackData,
                                                           void*);
     static std::vector<char> readFile(const std::string& filename);
-    void createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties,
-                      vk::raii::Buffer& buffer, vk::raii::DeviceMemory& bufferMemory);
-    void copyBuffer(vk::raii::Buffer& srcBuffer, vk::raii::Buffer& dstBuffer, vk::DeviceSize size);
+    void createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, VmaAllocationCreateFlags allocationFlags,
+                      GpuBuffer& buffer);
 };
 
 class ImGuiSink : public spdlog::sinks::base_sink<std::mutex>
@@ -290,10 +821,19 @@ class ImGuiSink : public spdlog::sinks::base_sink<std::mutex>
         ImVec4 color;
     };
 
-    std::vector<LogEntry> buffer;
     size_t max_size = 1024;
 
+    // Under the sink's lock, since any thread may log while the UI thread draws
+    void draw()
+    {
+        std::lock_guard lock(base_sink<std::mutex>::mutex_);
+        for (auto& entry : buffer)
+            ImGui::TextColored(entry.color, "%s", entry.msg.c_str());
+    }
+
   protected:
+    std::vector<LogEntry> buffer;
+
     void sink_it_(const spdlog::details::log_msg& msg) override
     {
         spdlog::memory_buf_t formatted;
@@ -0,0 +1,40 @@
+#include <frame_allocator.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+FrameAllocator::FrameAllocator(VmaAllocator allocator, vk::BufferUsageFlags usage, vk::DeviceSize frameSize,
+                               uint32_t framesInFlight, vk::DeviceSize alignment)
+    : alignment(std::max<vk::DeviceSize>(alignment, 1))
+{
+    // Every region starts aligned, so an allocation's offset is aligned wherever it is
+    this->frameSize = (frameSize + this->alignment - 1) / this->alignment * this->alignment;
+
+    vk::BufferCreateInfo bufferInfo{};
+    bufferInfo.setSize(this->frameSize * framesInFlight).setUsage(usage).setSharingMode(vk::SharingMode::eExclusive);
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_AUTO;
+    allocInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    buffer = GpuBuffer(allocator, bufferInfo, allocInfo);
+}
+
+void FrameAllocator::beginFrame(uint32_t frame)
+{
+    frameBegin = frame * frameSize;
+    head = frameBegin;
+}
+
+FrameAllocator::Allocation FrameAllocator::allocate(vk::DeviceSize size)
+{
+    vk::DeviceSize offset = (head + alignment - 1) / alignment * alignment;
+    if (offset + size > frameBegin + frameSize)
+        throw std::runtime_error("frame allocator is out of memory!");
+    head = offset + size;
+    return Allocation{ static_cast<uint8_t*>(buffer.getMapped()) + offset, offset, size };
+}
+
+void FrameAllocator::flush() const
+{
+    if (head > frameBegin)
+        buffer.flush(frameBegin, head - frameBegin);
+}
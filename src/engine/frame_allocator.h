@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+#include <gpu_memory.h>
+
+// Per-frame scratch memory for data the CPU rewrites every frame. One persistently mapped, host-visible buffer is split
+// into a region per frame in flight; allocations are bumped off the current frame's region and all of them are given
+// back at once when that frame comes around again, after its fence.
+class FrameAllocator
+{
+  public:
+    struct Allocation {
+        void* data;
+        // From the start of getBuffer()
+        vk::DeviceSize offset;
+        vk::DeviceSize size;
+    };
+
+    FrameAllocator(std::nullptr_t) {}
+    // alignment applies to every allocation's offset, e.g. minStorageBufferOffsetAlignment for storage buffers
+    FrameAllocator(VmaAllocator allocator, vk::BufferUsageFlags usage, vk::DeviceSize frameSize,
+                   uint32_t framesInFlight, vk::DeviceSize alignment);
+
+    // Call once per frame after waiting for its fence; releases what was allocated the last time the frame ran
+    void beginFrame(uint32_t frame);
+    // Throws when the frame's region is full
+    Allocation allocate(vk::DeviceSize size);
+    // Makes this frame's writes visible to the device, for memory that isn't host coherent
+    void flush() const;
+
+    [[nodiscard]] vk::Buffer getBuffer() const { return *buffer; }
+    [[nodiscard]] vk::DeviceSize getFrameSize() const { return frameSize; }
+    [[nodiscard]] vk::DeviceSize getUsed() const { return head - frameBegin; }
+
+  private:
+    GpuBuffer buffer = nullptr;
+    vk::DeviceSize frameSize = 0;
+    vk::DeviceSize alignment = 1;
+    vk::DeviceSize frameBegin = 0;
+    vk::DeviceSize head = 0;
+};
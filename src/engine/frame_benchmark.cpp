@@ -0,0 +1,122 @@
+#include <frame_benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+void FrameBenchmark::reset(uint32_t expectedFrames)
+{
+    timings.clear();
+    timings.reserve(expectedFrames);
+}
+
+TimingSummary FrameBenchmark::summarize(std::vector<double> samples)
+{
+    TimingSummary summary{};
+    if (samples.empty())
+        return summary;
+
+    std::ranges::sort(samples);
+    auto percentile = [&](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(samples.size()))) - 1;
+        return samples[std::min(rank, samples.size() - 1)];
+    };
+    summary.min = samples.front();
+    summary.max = samples.back();
+    summary.avg = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+    summary.p50 = percentile(0.50);
+    summary.p95 = percentile(0.95);
+    summary.p99 = percentile(0.99);
+    return summary;
+}
+
+TimingSummary FrameBenchmark::summarizeCpu() const
+{
+    std::vector<double> samples;
+    samples.reserve(timings.size());
+    for (auto& timing : timings)
+        samples.push_back(timing.cpuMs);
+    return summarize(std::move(samples));
+}
+
+std::optional<TimingSummary> FrameBenchmark::summarizeGpu() const
+{
+    std::vector<double> samples;
+    samples.reserve(timings.size());
+    for (auto& timing : timings) {
+        if (timing.gpuMs.has_value())
+            samples.push_back(timing.gpuMs.value());
+    }
+    if (samples.empty())
+        return std::nullopt;
+    return summarize(std::move(samples));
+}
+
+void FrameBenchmark::writeReport(const std::filesystem::path& path, const std::string& deviceName) const
+{
+    if (path.has_parent_path())
+        std::filesystem::create_directories(path.parent_path());
+
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("failed to open benchmark report " + path.string());
+    }
+
+    if (path.extension() == ".csv") {
+        writeCsv(out);
+    } else {
+        writeJson(out, deviceName);
+    }
+}
+
+void FrameBenchmark::writeCsv(std::ostream& out) const
+{
+    out << "frame,frame_ms,cpu_ms,gpu_ms\n";
+    for (auto& timing : timings) {
+        out << timing.frame << ',' << timing.frameMs << ',' << timing.cpuMs << ',';
+        if (timing.gpuMs.has_value())
+            out << timing.gpuMs.value();
+        out << '\n';
+    }
+}
+
+void FrameBenchmark::writeJson(std::ostream& out, const std::string& deviceName) const
+{
+    auto writeSummary = [&](const TimingSummary& s) {
+        out << "{ \"min\": " << s.min << ", \"avg\": " << s.avg << ", \"p50\": " << s.p50 << ", \"p95\": " << s.p95
+            << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << " }";
+    };
+
+    std::string escapedName;
+    for (char c : deviceName) {
+        if (c == '"' || c == '\\')
+            escapedName.push_back('\\');
+        escapedName.push_back(c);
+    }
+
+    out << "{\n";
+    out << "  \"device\": \"" << escapedName << "\",\n";
+    out << "  \"frames\": " << timings.size() << ",\n";
+    out << "  \"load_ms\": " << loadMs << ",\n";
+    out << "  \"cpu_ms\": ";
+    writeSummary(summarizeCpu());
+    out << ",\n  \"gpu_ms\": ";
+    if (auto gpu = summarizeGpu())
+        writeSummary(gpu.value());
+    else
+        out << "null";
+    out << ",\n  \"timings\": [\n";
+    for (size_t i = 0; i < timings.size(); ++i) {
+        auto& timing = timings[i];
+        out << "    { \"frame\": " << timing.frame << ", \"frame_ms\": " << timing.frameMs
+            << ", \"cpu_ms\": " << timing.cpuMs << ", \"gpu_ms\": ";
+        if (timing.gpuMs.has_value())
+            out << timing.gpuMs.value();
+        else
+            out << "null";
+        out << (i + 1 < timings.size() ? " },\n" : " }\n");
+    }
+    out << "  ]\n}\n";
+}
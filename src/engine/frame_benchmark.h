@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <vector>
+
+enum class CameraPath { Static, Orbit };
+
+struct FrameTiming {
+    uint32_t frame;
+    double frameMs;
+    double cpuMs;
+    std::optional<double> gpuMs;
+};
+
+struct TimingSummary {
+    double min = 0.0;
+    double avg = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+// Collects per-frame timings for a fixed-length run and writes them out as CSV (".csv") or JSON (anything else).
+class FrameBenchmark
+{
+  public:
+    void reset(uint32_t expectedFrames);
+    void setLoadTime(double ms) { loadMs = ms; }
+    void record(const FrameTiming& timing) { timings.push_back(timing); }
+    [[nodiscard]] size_t size() const { return timings.size(); }
+
+    [[nodiscard]] TimingSummary summarizeCpu() const;
+    [[nodiscard]] std::optional<TimingSummary> summarizeGpu() const;
+    void writeReport(const std::filesystem::path& path, const std::string& deviceName) const;
+
+  private:
+    double loadMs = 0.0;
+    std::vector<FrameTiming> timings;
+
+    static TimingSummary summarize(std::vector<double> samples);
+    void writeCsv(std::ostream& out) const;
+    void writeJson(std::ostream& out, const std::string& deviceName) const;
+};
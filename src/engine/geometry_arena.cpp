@@ -0,0 +1,215 @@
+#include <geometry_arena.h>
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+RangeAllocator::RangeAllocator(vk::DeviceSize capacity) : capacity(capacity), freeBytes(capacity)
+{
+    if (capacity > 0)
+        freeRanges.emplace(0, capacity);
+}
+
+std::optional<vk::DeviceSize> RangeAllocator::allocate(vk::DeviceSize size, vk::DeviceSize alignment)
+{
+    if (size == 0)
+        return 0;
+
+    for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+        auto [rangeOffset, rangeSize] = *it;
+        vk::DeviceSize offset = (rangeOffset + alignment - 1) / alignment * alignment;
+        vk::DeviceSize padding = offset - rangeOffset;
+        if (padding + size > rangeSize)
+            continue;
+
+        freeRanges.erase(it);
+        // Whatever the alignment skipped over, and whatever is left after the allocation, stays free
+        if (padding > 0)
+            freeRanges.emplace(rangeOffset, padding);
+        if (padding + size < rangeSize)
+            freeRanges.emplace(offset + size, rangeSize - padding - size);
+        freeBytes -= size;
+        return offset;
+    }
+    return std::nullopt;
+}
+
+void RangeAllocator::free(vk::DeviceSize offset, vk::DeviceSize size)
+{
+    if (size == 0)
+        return;
+    freeBytes += size;
+
+    auto next = freeRanges.lower_bound(offset);
+    if (next != freeRanges.end() && offset + size == next->first) {
+        size += next->second;
+        next = freeRanges.erase(next);
+    }
+    if (next != freeRanges.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            offset = prev->first;
+            size += prev->second;
+            freeRanges.erase(prev);
+        }
+    }
+    freeRanges.emplace(offset, size);
+}
+
+vk::DeviceSize RangeAllocator::getLargestFreeRange() const
+{
+    vk::DeviceSize largest = 0;
+    for (auto& [offset, size] : freeRanges)
+        largest = std::max(largest, size);
+    return largest;
+}
+
+GeometryArena::GeometryArena(VmaAllocator allocator, vk::DeviceSize vertexPageSize, vk::DeviceSize indexPageSize,
+                             uint32_t framesInFlight)
+    : allocator(allocator), vertexPageSize(vertexPageSize), indexPageSize(indexPageSize),
+      framesInFlight(framesInFlight)
+{
+}
+
+GeometryAllocation GeometryArena::allocate(uint32_t vertexCount, uint32_t vertexStride, uint32_t indexCount,
+                                           uint32_t indexStride)
+{
+    vk::DeviceSize vertexBytes = static_cast<vk::DeviceSize>(vertexCount) * vertexStride;
+    vk::DeviceSize indexBytes = static_cast<vk::DeviceSize>(indexCount) * indexStride;
+
+    GeometryAllocation allocation{};
+    for (uint32_t page = 0; page < pages.size(); ++page) {
+        if (tryAllocate(page, vertexBytes, vertexStride, indexBytes, indexStride, allocation))
+            return allocation;
+    }
+
+    // A mesh bigger than a page gets a page of its own size
+    createPage(vertexBytes, indexBytes);
+    if (!tryAllocate(static_cast<uint32_t>(pages.size() - 1), vertexBytes, vertexStride, indexBytes, indexStride,
+                     allocation))
+        throw std::runtime_error("failed to allocate geometry!");
+    return allocation;
+}
+
+void GeometryArena::free(const GeometryAllocation& allocation)
+{
+    if (allocation.valid())
+        pendingFrees.push_back(PendingFree{ allocation, frame });
+}
+
+void GeometryArena::nextFrame()
+{
+    frame++;
+    std::erase_if(pendingFrees, [&](const PendingFree& pending) {
+        if (frame - pending.frame < framesInFlight)
+            return false;
+        release(pending.allocation);
+        return true;
+    });
+}
+
+GeometryArena::Stats GeometryArena::getStats() const
+{
+    Stats stats{};
+    stats.pageCount = static_cast<uint32_t>(pages.size());
+    stats.allocationCount = allocationCount;
+    for (auto& page : pages) {
+        stats.vertexBytes += page.vertexRanges.getCapacity();
+        stats.vertexFreeBytes += page.vertexRanges.getFreeBytes();
+        stats.indexBytes += page.indexRanges.getCapacity();
+        stats.indexFreeBytes += page.indexRanges.getFreeBytes();
+        stats.largestFreeVertexRange = std::max(stats.largestFreeVertexRange, page.vertexRanges.getLargestFreeRange());
+    }
+    return stats;
+}
+
+void GeometryArena::createPage(vk::DeviceSize minVertexBytes, vk::DeviceSize minIndexBytes)
+{
+    Page page{};
+    vk::DeviceSize vertexBytes = std::max(vertexPageSize, minVertexBytes);
+    vk::DeviceSize indexBytes = std::max(indexPageSize, minIndexBytes);
+
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+    allocInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+
+    vk::BufferCreateInfo vertexInfo{};
+    vertexInfo.setSize(vertexBytes)
+        .setUsage(vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst)
+        .setSharingMode(vk::SharingMode::eExclusive);
+    page.vertices = GpuBuffer(allocator, vertexInfo, allocInfo);
+
+    vk::BufferCreateInfo indexInfo{};
+    indexInfo.setSize(indexBytes)
+        .setUsage(vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst)
+        .setSharingMode(vk::SharingMode::eExclusive);
+    page.indices = GpuBuffer(allocator, indexInfo, allocInfo);
+
+    page.vertexRanges = RangeAllocator(vertexBytes);
+    page.indexRanges = RangeAllocator(indexBytes);
+    pages.push_back(std::move(page));
+}
+
+bool GeometryArena::tryAllocate(uint32_t pageIndex, vk::DeviceSize vertexBytes, uint32_t vertexStride,
+                                vk::DeviceSize indexBytes, uint32_t indexStride, GeometryAllocation& allocation)
+{
+    Page& page = pages[pageIndex];
+    // Vertex ranges are aligned to the stride so that the offset is a whole number of vertices
+    auto vertexOffset = page.vertexRanges.allocate(vertexBytes, vertexStride);
+    if (!vertexOffset.has_value())
+        return false;
+    // Likewise index ranges to their index size, so 16- and 32-bit ranges can sit side by side
+    auto indexOffset = page.indexRanges.allocate(indexBytes, indexStride);
+    if (!indexOffset.has_value()) {
+        page.vertexRanges.free(vertexOffset.value(), vertexBytes);
+        return false;
+    }
+
+    allocation.page = pageIndex;
+    allocation.vertexOffset = vertexOffset.value();
+    allocation.vertexSize = vertexBytes;
+    allocation.indexOffset = indexOffset.value();
+    allocation.indexSize = indexBytes;
+    allocation.firstVertex = static_cast<int32_t>(vertexOffset.value() / vertexStride);
+    allocation.firstIndex = static_cast<uint32_t>(indexOffset.value() / indexStride);
+    allocation.indexCount = static_cast<uint32_t>(indexBytes / indexStride);
+    allocationCount++;
+    return true;
+}
+
+void GeometryArena::release(const GeometryAllocation& allocation)
+{
+    Page& page = pages[allocation.page];
+    page.vertexRanges.free(allocation.vertexOffset, allocation.vertexSize);
+    page.indexRanges.free(allocation.indexOffset, allocation.indexSize);
+    allocationCount--;
+}
+
+std::vector<IndexWindow> splitIndexWindows(std::span<const uint32_t> indices)
+{
+    if (indices.size() % 3 != 0)
+        return {};
+
+    std::vector<IndexWindow> windows;
+    IndexWindow window{ 0, 0, UINT32_MAX, 0 };
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        auto [low, high] = std::minmax({ indices[i], indices[i + 1], indices[i + 2] });
+        if (high - low > UINT16_MAX)
+            return {};
+
+        uint32_t minVertex = std::min(window.minVertex, low);
+        uint32_t maxVertex = std::max(window.maxVertex, high);
+        if (window.indexCount > 0 && maxVertex - minVertex > UINT16_MAX) {
+            windows.push_back(window);
+            window = IndexWindow{ i, 0, low, high };
+            minVertex = low;
+            maxVertex = high;
+        }
+        window.minVertex = minVertex;
+        window.maxVertex = maxVertex;
+        window.indexCount += 3;
+    }
+    if (window.indexCount > 0)
+        windows.push_back(window);
+    return windows;
+}
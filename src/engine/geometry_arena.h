@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <gpu_memory.h>
+
+// First-fit free list over a [0, capacity) range of bytes. Alignments don't have to be powers of two, so a vertex
+// range can be aligned to its stride and addressed with a vertex offset.
+class RangeAllocator
+{
+  public:
+    RangeAllocator() = default;
+    explicit RangeAllocator(vk::DeviceSize capacity);
+
+    std::optional<vk::DeviceSize> allocate(vk::DeviceSize size, vk::DeviceSize alignment);
+    // Returns [offset, offset + size) to the free list, merging it with its neighbours
+    void free(vk::DeviceSize offset, vk::DeviceSize size);
+
+    [[nodiscard]] vk::DeviceSize getCapacity() const { return capacity; }
+    [[nodiscard]] vk::DeviceSize getFreeBytes() const { return freeBytes; }
+    [[nodiscard]] vk::DeviceSize getLargestFreeRange() const;
+
+  private:
+    vk::DeviceSize capacity = 0;
+    vk::DeviceSize freeBytes = 0;
+    // offset -> size
+    std::map<vk::DeviceSize, vk::DeviceSize> freeRanges;
+};
+
+// Where a mesh lives in the arena. firstIndex and vertexOffset feed straight into vkCmdDrawIndexed, with firstIndex
+// counted in indices of the mesh's own index type.
+struct GeometryAllocation {
+    uint32_t page = UINT32_MAX;
+    vk::DeviceSize vertexOffset = 0;
+    vk::DeviceSize vertexSize = 0;
+    vk::DeviceSize indexOffset = 0;
+    vk::DeviceSize indexSize = 0;
+    int32_t firstVertex = 0;
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+
+    [[nodiscard]] bool valid() const { return page != UINT32_MAX; }
+};
+
+// A run of a triangle list whose vertices all lie in [minVertex, minVertex + 65535], so it can be drawn with 16-bit
+// indices rebased onto minVertex
+struct IndexWindow {
+    size_t firstIndex;
+    size_t indexCount;
+    uint32_t minVertex;
+    uint32_t maxVertex;
+};
+
+// Splits a triangle list into as few IndexWindows as a single in-order pass finds. Returns nothing if the list isn't
+// made of whole triangles or one triangle alone spans more than 16 bits.
+std::vector<IndexWindow> splitIndexWindows(std::span<const uint32_t> indices);
+
+// Sub-allocates every mesh out of a few large device-local vertex and index buffers so that draws only need one
+// bind per page. A new page is created when none of the existing ones has room. Freed ranges are held back until
+// the frames that may still read them have finished.
+class GeometryArena
+{
+  public:
+    struct Stats {
+        uint32_t pageCount;
+        uint32_t allocationCount;
+        vk::DeviceSize vertexBytes;
+        vk::DeviceSize vertexFreeBytes;
+        vk::DeviceSize indexBytes;
+        vk::DeviceSize indexFreeBytes;
+        vk::DeviceSize largestFreeVertexRange;
+    };
+
+    GeometryArena(std::nullptr_t) {}
+    GeometryArena(VmaAllocator allocator, vk::DeviceSize vertexPageSize, vk::DeviceSize indexPageSize,
+                  uint32_t framesInFlight);
+
+    // indexStride is 2 or 4; index ranges of both sizes share a page's index buffer
+    GeometryAllocation allocate(uint32_t vertexCount, uint32_t vertexStride, uint32_t indexCount,
+                                uint32_t indexStride);
+    // Meshes are never unloaded yet, so nothing calls this for now and ranges are only ever handed out
+    void free(const GeometryAllocation& allocation);
+    // Call once per frame after waiting for the oldest frame in flight; releases frees that are now safe to reuse
+    void nextFrame();
+
+    [[nodiscard]] vk::Buffer getVertexBuffer(uint32_t page) const { return *pages[page].vertices; }
+    [[nodiscard]] vk::Buffer getIndexBuffer(uint32_t page) const { return *pages[page].indices; }
+    [[nodiscard]] uint32_t getPageCount() const { return static_cast<uint32_t>(pages.size()); }
+    [[nodiscard]] Stats getStats() const;
+
+  private:
+    struct Page {
+        GpuBuffer vertices = nullptr;
+        GpuBuffer indices = nullptr;
+        RangeAllocator vertexRanges;
+        RangeAllocator indexRanges;
+    };
+
+    struct PendingFree {
+        GeometryAllocation allocation;
+        uint64_t frame;
+    };
+
+    VmaAllocator allocator = VK_NULL_HANDLE;
+    vk::DeviceSize vertexPageSize = 0;
+    vk::DeviceSize indexPageSize = 0;
+    uint32_t framesInFlight = 0;
+    uint64_t frame = 0;
+    uint32_t allocationCount = 0;
+
+    std::vector<Page> pages;
+    std::vector<PendingFree> pendingFrees;
+
+    void createPage(vk::DeviceSize minVertexBytes, vk::DeviceSize minIndexBytes);
+    bool tryAllocate(uint32_t pageIndex, vk::DeviceSize vertexBytes, uint32_t vertexStride,
+                     vk::DeviceSize indexBytes, uint32_t indexStride, GeometryAllocation& allocation);
+    void release(const GeometryAllocation& allocation);
+};
@@ -0,0 +1,223 @@
+#define VMA_IMPLEMENTATION
+#include <gpu_memory.h>
+
+#include <stdexcept>
+#include <utility>
+
+GpuAllocator::GpuAllocator(const vk::raii::Instance& instance, const vk::raii::PhysicalDevice& physicalDevice,
+                           const vk::raii::Device& device, uint32_t vulkanApiVersion)
+{
+    VmaVulkanFunctions functions{};
+    functions.vkGetInstanceProcAddr = &vkGetInstanceProcAddr;
+    functions.vkGetDeviceProcAddr = &vkGetDeviceProcAddr;
+
+    VmaAllocatorCreateInfo createInfo{};
+    createInfo.instance = static_cast<VkInstance>(*instance);
+    createInfo.physicalDevice = static_cast<VkPhysicalDevice>(*physicalDevice);
+    createInfo.device = static_cast<VkDevice>(*device);
+    createInfo.vulkanApiVersion = vulkanApiVersion;
+    createInfo.pVulkanFunctions = &functions;
+
+    if (vmaCreateAllocator(&createInfo, &allocator) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create memory allocator!");
+    }
+}
+
+GpuAllocator::~GpuAllocator() { clear(); }
+
+GpuAllocator::GpuAllocator(GpuAllocator&& other) noexcept : allocator(std::exchange(other.allocator, VK_NULL_HANDLE))
+{
+}
+
+GpuAllocator& GpuAllocator::operator=(GpuAllocator&& other) noexcept
+{
+    if (this != &other) {
+        clear();
+        allocator = std::exchange(other.allocator, VK_NULL_HANDLE);
+    }
+    return *this;
+}
+
+void GpuAllocator::clear()
+{
+    if (allocator == VK_NULL_HANDLE)
+        return;
+    vmaDestroyAllocator(allocator);
+    allocator = VK_NULL_HANDLE;
+}
+
+VmaDefragmentationStats GpuAllocator::defragmentImages(
+    const std::function<bool(const GpuImage&)>& canMove,
+    const std::function<void(const std::vector<ImageMove>&)>& copyMoves)
+{
+    VmaAllocatorInfo allocatorInfo{};
+    vmaGetAllocatorInfo(allocator, &allocatorInfo);
+
+    VmaDefragmentationInfo defragInfo{};
+    defragInfo.flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT;
+
+    VmaDefragmentationContext context = VK_NULL_HANDLE;
+    if (vmaBeginDefragmentation(allocator, &defragInfo, &context) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin defragmentation!");
+    }
+
+    VmaDefragmentationStats stats{};
+    try {
+        while (true) {
+            VmaDefragmentationPassMoveInfo pass{};
+            VkResult result = vmaBeginDefragmentationPass(allocator, context, &pass);
+            if (result == VK_SUCCESS)
+                break;
+            if (result != VK_INCOMPLETE)
+                throw std::runtime_error("failed to begin defragmentation pass!");
+
+            // Only GpuImages leave a pointer to themselves in their allocation
+            std::vector<ImageMove> moves;
+            for (uint32_t i = 0; i < pass.moveCount; ++i) {
+                auto& move = pass.pMoves[i];
+                VmaAllocationInfo allocationInfo{};
+                vmaGetAllocationInfo(allocator, move.srcAllocation, &allocationInfo);
+                auto* owner = static_cast<GpuImage*>(allocationInfo.pUserData);
+                if (owner == nullptr || !canMove(*owner)) {
+                    move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                    continue;
+                }
+
+                VkImage newImage = VK_NULL_HANDLE;
+                if (vkCreateImage(allocatorInfo.device, &static_cast<const VkImageCreateInfo&>(owner->info), nullptr,
+                                  &newImage) != VK_SUCCESS ||
+                    vmaBindImageMemory(allocator, move.dstTmpAllocation, newImage) != VK_SUCCESS) {
+                    vkDestroyImage(allocatorInfo.device, newImage, nullptr);
+                    move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                    continue;
+                }
+                moves.push_back(ImageMove{ owner, newImage });
+            }
+
+            if (!moves.empty())
+                copyMoves(moves);
+
+            // The allocation handles stay valid across the pass, only the images bound to them change
+            for (const ImageMove& move : moves) {
+                vkDestroyImage(allocatorInfo.device, static_cast<VkImage>(move.image->image), nullptr);
+                move.image->image = move.newImage;
+            }
+
+            result = vmaEndDefragmentationPass(allocator, context, &pass);
+            if (result == VK_SUCCESS)
+                break;
+            if (result != VK_INCOMPLETE)
+                throw std::runtime_error("failed to end defragmentation pass!");
+        }
+    } catch (...) {
+        vmaEndDefragmentation(allocator, context, &stats);
+        throw;
+    }
+
+    vmaEndDefragmentation(allocator, context, &stats);
+    return stats;
+}
+
+GpuBuffer::GpuBuffer(VmaAllocator allocator, const vk::BufferCreateInfo& bufferInfo,
+                     const VmaAllocationCreateInfo& allocationInfo)
+    : allocator(allocator), size(bufferInfo.size)
+{
+    VkBuffer vkBuffer = VK_NULL_HANDLE;
+    VmaAllocationInfo info{};
+    if (vmaCreateBuffer(allocator, &static_cast<const VkBufferCreateInfo&>(bufferInfo), &allocationInfo, &vkBuffer,
+                        &allocation, &info) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate buffer memory!");
+    }
+    buffer = vkBuffer;
+    mapped = info.pMappedData;
+}
+
+GpuBuffer::~GpuBuffer() { clear(); }
+
+GpuBuffer::GpuBuffer(GpuBuffer&& other) noexcept
+    : allocator(std::exchange(other.allocator, VK_NULL_HANDLE)),
+      allocation(std::exchange(other.allocation, VK_NULL_HANDLE)), buffer(std::exchange(other.buffer, nullptr)),
+      size(std::exchange(other.size, 0)), mapped(std::exchange(other.mapped, nullptr))
+{
+}
+
+GpuBuffer& GpuBuffer::operator=(GpuBuffer&& other) noexcept
+{
+    if (this != &other) {
+        clear();
+        allocator = std::exchange(other.allocator, VK_NULL_HANDLE);
+        allocation = std::exchange(other.allocation, VK_NULL_HANDLE);
+        buffer = std::exchange(other.buffer, nullptr);
+        size = std::exchange(other.size, 0);
+        mapped = std::exchange(other.mapped, nullptr);
+    }
+    return *this;
+}
+
+void GpuBuffer::flush(vk::DeviceSize offset, vk::DeviceSize range) const
+{
+    // No-op on HOST_COHERENT memory
+    vmaFlushAllocation(allocator, allocation, offset, range);
+}
+
+void GpuBuffer::invalidate(vk::DeviceSize offset, vk::DeviceSize range) const
+{
+    vmaInvalidateAllocation(allocator, allocation, offset, range);
+}
+
+void GpuBuffer::clear()
+{
+    if (allocation != VK_NULL_HANDLE)
+        vmaDestroyBuffer(allocator, static_cast<VkBuffer>(buffer), allocation);
+    allocation = VK_NULL_HANDLE;
+    buffer = nullptr;
+    mapped = nullptr;
+}
+
+GpuImage::GpuImage(VmaAllocator allocator, const vk::ImageCreateInfo& imageInfo,
+                   const VmaAllocationCreateInfo& allocationInfo)
+    : allocator(allocator), info(imageInfo)
+{
+    info.setPNext(nullptr);
+    VkImage vkImage = VK_NULL_HANDLE;
+    if (vmaCreateImage(allocator, &static_cast<const VkImageCreateInfo&>(imageInfo), &allocationInfo, &vkImage,
+                       &allocation, nullptr) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate image memory!");
+    }
+    image = vkImage;
+    // Lets GpuAllocator::defragmentImages() find the owner of a moved allocation
+    vmaSetAllocationUserData(allocator, allocation, this);
+}
+
+GpuImage::~GpuImage() { clear(); }
+
+GpuImage::GpuImage(GpuImage&& other) noexcept
+    : allocator(std::exchange(other.allocator, VK_NULL_HANDLE)),
+      allocation(std::exchange(other.allocation, VK_NULL_HANDLE)), image(std::exchange(other.image, nullptr)),
+      info(other.info)
+{
+    if (allocation != VK_NULL_HANDLE)
+        vmaSetAllocationUserData(allocator, allocation, this);
+}
+
+GpuImage& GpuImage::operator=(GpuImage&& other) noexcept
+{
+    if (this != &other) {
+        clear();
+        allocator = std::exchange(other.allocator, VK_NULL_HANDLE);
+        allocation = std::exchange(other.allocation, VK_NULL_HANDLE);
+        image = std::exchange(other.image, nullptr);
+        info = other.info;
+        if (allocation != VK_NULL_HANDLE)
+            vmaSetAllocationUserData(allocator, allocation, this);
+    }
+    return *this;
+}
+
+void GpuImage::clear()
+{
+    if (allocation != VK_NULL_HANDLE)
+        vmaDestroyImage(allocator, static_cast<VkImage>(image), allocation);
+    allocation = VK_NULL_HANDLE;
+    image = nullptr;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Vulkan
+#include <vulkan/vulkan_raii.hpp>
+
+// VMA
+#include <vk_mem_alloc.h>
+
+class GpuImage;
+
+// Owns the VmaAllocator. Declare it after the device so that it is destroyed first, and before every
+// GpuBuffer/GpuImage so that those are destroyed before it.
+class GpuAllocator
+{
+  public:
+    struct ImageMove {
+        GpuImage* image;
+        // Created like image and bound to its new place
+        vk::Image newImage;
+    };
+
+    GpuAllocator(std::nullptr_t) {}
+    GpuAllocator(const vk::raii::Instance& instance, const vk::raii::PhysicalDevice& physicalDevice,
+                 const vk::raii::Device& device, uint32_t vulkanApiVersion);
+    ~GpuAllocator();
+
+    GpuAllocator(const GpuAllocator&) = delete;
+    GpuAllocator& operator=(const GpuAllocator&) = delete;
+    GpuAllocator(GpuAllocator&& other) noexcept;
+    GpuAllocator& operator=(GpuAllocator&& other) noexcept;
+
+    VmaAllocator operator*() const { return allocator; }
+
+    // Packs the sub-allocated GpuImages of VMA's default pools closer together, so device memory blocks that empty
+    // out can be freed. Buffers stay where they are, and so do images canMove turns down. copyMoves must record and
+    // finish copying every level of each old image into its new one before returning; the old images are destroyed
+    // and their GpuImages rebound to the new ones afterwards, so views of them have to be recreated.
+    VmaDefragmentationStats defragmentImages(const std::function<bool(const GpuImage&)>& canMove,
+                                             const std::function<void(const std::vector<ImageMove>&)>& copyMoves);
+
+  private:
+    VmaAllocator allocator = VK_NULL_HANDLE;
+
+    void clear();
+};
+
+class GpuBuffer
+{
+  public:
+    GpuBuffer(std::nullptr_t) {}
+    GpuBuffer(VmaAllocator allocator, const vk::BufferCreateInfo& bufferInfo,
+              const VmaAllocationCreateInfo& allocationInfo);
+    ~GpuBuffer();
+
+    GpuBuffer(const GpuBuffer&) = delete;
+    GpuBuffer& operator=(const GpuBuffer&) = delete;
+    GpuBuffer(GpuBuffer&& other) noexcept;
+    GpuBuffer& operator=(GpuBuffer&& other) noexcept;
+
+    vk::Buffer operator*() const { return buffer; }
+    [[nodiscard]] VmaAllocation getAllocation() const { return allocation; }
+    [[nodiscard]] vk::DeviceSize getSize() const { return size; }
+    // Only valid for allocations created with VMA_ALLOCATION_CREATE_MAPPED_BIT
+    [[nodiscard]] void* getMapped() const { return mapped; }
+    void flush(vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE) const;
+    // Makes device writes visible before reading through getMapped()
+    void invalidate(vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE) const;
+
+  private:
+    VmaAllocator allocator = VK_NULL_HANDLE;
+    VmaAllocation allocation = VK_NULL_HANDLE;
+    vk::Buffer buffer = nullptr;
+    vk::DeviceSize size = 0;
+    void* mapped = nullptr;
+
+    void clear();
+};
+
+class GpuImage
+{
+  public:
+    GpuImage(std::nullptr_t) {}
+    GpuImage(VmaAllocator allocator, const vk::ImageCreateInfo& imageInfo,
+             const VmaAllocationCreateInfo& allocationInfo);
+    ~GpuImage();
+
+    GpuImage(const GpuImage&) = delete;
+    GpuImage& operator=(const GpuImage&) = delete;
+    GpuImage(GpuImage&& other) noexcept;
+    GpuImage& operator=(GpuImage&& other) noexcept;
+
+    vk::Image operator*() const { return image; }
+    [[nodiscard]] VmaAllocation getAllocation() const { return allocation; }
+    // What the image was created with, without the pNext chain
+    [[nodiscard]] const vk::ImageCreateInfo& getInfo() const { return info; }
+
+  private:
+    friend class GpuAllocator;
+
+    VmaAllocator allocator = VK_NULL_HANDLE;
+    VmaAllocation allocation = VK_NULL_HANDLE;
+    vk::Image image = nullptr;
+    vk::ImageCreateInfo info{};
+
+    void clear();
+};
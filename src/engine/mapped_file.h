@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+// A read-only memory mapping of a whole file. The file itself is closed once mapped; the pages stay valid until the
+// MappedFile is destroyed.
+class MappedFile
+{
+  public:
+    MappedFile(std::nullptr_t) {}
+    explicit MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    [[nodiscard]] std::span<const std::byte> getData() const { return { data, size }; }
+
+  private:
+    const std::byte* data = nullptr;
+    size_t size = 0;
+
+    void clear();
+};
@@ -0,0 +1,77 @@
+#include <engine.h>
+
+namespace
+{
+// Each level aims for half the triangles of the one before it
+constexpr float LOD_REDUCTION = 0.5f;
+// A level that keeps more than this share of the previous level's triangles isn't worth its memory, and the chain
+// stops there
+constexpr float LOD_MIN_REDUCTION = 0.85f;
+constexpr size_t LOD_MIN_TRIANGLES = 64;
+// Relative to the mesh's extent; past this the simplifier stops removing triangles
+constexpr float LOD_MAX_ERROR = 0.05f;
+// Keeps the projected error finite with the camera inside an object's bounds
+constexpr float LOD_MIN_DISTANCE = 1e-4f;
+} // namespace
+
+std::vector<MeshLod> buildLodChain(std::vector<uint32_t>& indices, const float* positions, size_t vertexCount,
+                                   size_t stride, bool lockBorder)
+{
+    size_t baseCount = indices.size();
+    std::vector<MeshLod> lods{ MeshLod{ 0, static_cast<uint32_t>(baseCount), 0.0f } };
+    if (baseCount < LOD_MIN_TRIANGLES * 3 || vertexCount == 0)
+        return lods;
+
+    // meshopt_simplify reports errors relative to the mesh's extent
+    float errorScale = meshopt_simplifyScale(positions, vertexCount, stride);
+    unsigned int options = lockBorder ? meshopt_SimplifyLockBorder : 0;
+
+    std::vector<uint32_t> simplified(baseCount);
+    size_t targetCount = baseCount;
+    while (lods.size() < MAX_MESH_LODS) {
+        targetCount = static_cast<size_t>(targetCount * LOD_REDUCTION) / 3 * 3;
+        if (targetCount < LOD_MIN_TRIANGLES * 3)
+            break;
+
+        // Always simplified from level 0, so each level's error is measured against the full resolution mesh
+        float error = 0.0f;
+        size_t count = meshopt_simplify(simplified.data(), indices.data(), baseCount, positions, vertexCount, stride,
+                                        targetCount, LOD_MAX_ERROR, options, &error);
+        if (count == 0 || count > lods.back().indexCount * LOD_MIN_REDUCTION)
+            break;
+        meshopt_optimizeVertexCache(simplified.data(), simplified.data(), count, vertexCount);
+
+        lods.push_back(MeshLod{ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(count),
+                                std::max(error * errorScale, lods.back().error) });
+        indices.insert(indices.end(), simplified.begin(), simplified.begin() + count);
+        targetCount = count;
+    }
+    return lods;
+}
+
+float getLodErrorScale(const glm::mat4& proj, float viewportHeight)
+{
+    // proj[1][1] is cot(fov / 2), flipped for Vulkan's y axis
+    return std::abs(proj[1][1]) * viewportHeight * 0.5f;
+}
+
+uint32_t selectLod(std::span<const MeshLod> lods, const Aabb& bounds, const glm::vec3& cameraPosition,
+                   float errorScale, float threshold, float hysteresis, uint32_t current)
+{
+    if (lods.empty())
+        return 0;
+
+    // Distance to the nearest point of the bounds, zero from inside them
+    glm::vec3 outside = glm::max(glm::max(bounds.min - cameraPosition, cameraPosition - bounds.max), glm::vec3(0.0f));
+    float pixelsPerUnit = errorScale / std::max(glm::length(outside), LOD_MIN_DISTANCE);
+
+    // Must match selectLod in shaders/cull.slang
+    uint32_t lod = std::min<uint32_t>(current, static_cast<uint32_t>(lods.size()) - 1);
+    while (lod > 0 && lods[lod].error * pixelsPerUnit > threshold)
+        --lod;
+    if (lod < current)
+        return lod;
+    while (lod + 1 < lods.size() && lods[lod + 1].error * pixelsPerUnit <= threshold * (1.0f - hysteresis))
+        ++lod;
+    return lod;
+}
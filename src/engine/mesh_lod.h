@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Expects the engine's GLM configuration, include through engine.h
+#include <glm/glm.hpp>
+
+#include <culling.h>
+
+// Longest LOD chain built for a mesh, the full resolution level included
+constexpr uint32_t MAX_MESH_LODS = 8;
+
+// One level of a mesh's LOD chain: a run of the mesh's indices drawn against the shared vertices. error is the
+// object-space distance the level may deviate from the full resolution mesh. Cooked levels are also split into a run
+// of the mesh's meshlets.
+struct MeshLod {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;
+    uint32_t firstMeshlet = 0;
+    uint32_t meshletCount = 0;
+};
+
+// Simplifies the triangle list in indices into successively coarser levels and appends each one to indices. Level 0
+// is indices as given. positions is read with stride bytes between vertices. lockBorder keeps open edges in place,
+// for meshes that were split into pieces which have to keep meeting.
+std::vector<MeshLod> buildLodChain(std::vector<uint32_t>& indices, const float* positions, size_t vertexCount,
+                                   size_t stride, bool lockBorder);
+
+// Pixels covered by one object-space unit at distance 1 from the camera, for a projection matrix and viewport height
+float getLodErrorScale(const glm::mat4& proj, float viewportHeight);
+
+// Picks the level to draw given the one drawn last. The coarsest level whose projected error stays under threshold
+// pixels is wanted, but a coarser level is only taken once its error drops below threshold * (1 - hysteresis), so an
+// object sitting at a transition doesn't flip between two levels every frame.
+uint32_t selectLod(std::span<const MeshLod> lods, const Aabb& bounds, const glm::vec3& cameraPosition,
+                   float errorScale, float threshold, float hysteresis, uint32_t current);
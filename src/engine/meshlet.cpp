@@ -0,0 +1,57 @@
+#include <meshlet.h>
+
+#include <algorithm>
+
+#include <meshoptimizer.h>
+
+namespace
+{
+// How much meshlet building favours tight backface cones over fewer, fuller meshlets
+constexpr float MESHLET_CONE_WEIGHT = 0.25f;
+} // namespace
+
+std::vector<CookedMeshlet> buildMeshlets(std::span<uint32_t> indices, const float* positions, size_t vertexCount,
+                                         size_t stride)
+{
+    if (indices.size() < 3 || vertexCount == 0)
+        return {};
+
+    size_t maxMeshlets = meshopt_buildMeshletsBound(indices.size(), MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES);
+    std::vector<meshopt_Meshlet> meshlets(maxMeshlets);
+    std::vector<unsigned int> meshletVertices(maxMeshlets * MESHLET_MAX_VERTICES);
+    std::vector<unsigned char> meshletTriangles(maxMeshlets * MESHLET_MAX_TRIANGLES * 3);
+    size_t meshletCount = meshopt_buildMeshlets(meshlets.data(), meshletVertices.data(), meshletTriangles.data(),
+                                                indices.data(), indices.size(), positions, vertexCount, stride,
+                                                MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES, MESHLET_CONE_WEIGHT);
+
+    std::vector<CookedMeshlet> cooked;
+    cooked.reserve(meshletCount);
+    std::vector<uint32_t> reordered;
+    reordered.reserve(indices.size());
+    for (size_t m = 0; m < meshletCount; ++m) {
+        const meshopt_Meshlet& meshlet = meshlets[m];
+        const unsigned int* vertices = &meshletVertices[meshlet.vertex_offset];
+        const unsigned char* triangles = &meshletTriangles[meshlet.triangle_offset];
+        meshopt_Bounds bounds =
+            meshopt_computeMeshletBounds(vertices, triangles, meshlet.triangle_count, positions, vertexCount, stride);
+
+        CookedMeshlet out{};
+        out.firstIndex = static_cast<uint32_t>(reordered.size());
+        out.triangleCount = meshlet.triangle_count;
+        out.center = { bounds.center[0], bounds.center[1], bounds.center[2] };
+        out.radius = bounds.radius;
+        out.coneApex = { bounds.cone_apex[0], bounds.cone_apex[1], bounds.cone_apex[2] };
+        out.coneAxis = { bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2] };
+        out.coneCutoff = bounds.cone_cutoff;
+        cooked.push_back(out);
+
+        for (size_t i = 0; i < meshlet.triangle_count * 3; ++i)
+            reordered.push_back(vertices[triangles[i]]);
+    }
+
+    // Every triangle should land in exactly one meshlet; if some didn't, the mesh is left as it was and drawn whole
+    if (reordered.size() != indices.size())
+        return {};
+    std::ranges::copy(reordered, indices.begin());
+    return cooked;
+}
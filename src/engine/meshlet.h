@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <cooked_model.h>
+
+// Cluster limits, the vertex count is also what VK_EXT_mesh_shader implementations handle best
+constexpr size_t MESHLET_MAX_VERTICES = 64;
+constexpr size_t MESHLET_MAX_TRIANGLES = 124;
+
+// Clusters the triangle list in indices into meshlets and rewrites indices in meshlet order, so each meshlet's
+// triangles are a contiguous run that can be drawn on its own. Meshlet firstIndex is relative to the start of
+// indices. positions is read with stride bytes between vertices.
+std::vector<CookedMeshlet> buildMeshlets(std::span<uint32_t> indices, const float* positions, size_t vertexCount,
+                                         size_t stride);
@@ -0,0 +1,257 @@
+#include <physics.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+#include <Jolt/Core/Factory.h>
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <Jolt/RegisterTypes.h>
+
+#include <collision_shapes.h>
+
+namespace
+{
+// Static bodies only collide with moving ones, moving ones with everything
+constexpr JPH::ObjectLayer LAYER_NON_MOVING = 0;
+constexpr JPH::ObjectLayer LAYER_MOVING = 1;
+constexpr JPH::uint LAYER_COUNT = 2;
+
+constexpr uint32_t MAX_PHYSICS_JOBS = 2048;
+constexpr uint32_t MAX_PHYSICS_BARRIERS = 8;
+constexpr size_t PHYSICS_TEMP_MEMORY = 32ull * 1024 * 1024;
+
+JPH::Vec3 toJolt(const glm::vec3& v)
+{
+    return JPH::Vec3(v.x, v.y, v.z);
+}
+} // namespace
+
+class PhysicsWorld::BroadPhaseLayers final : public JPH::BroadPhaseLayerInterface
+{
+  public:
+    JPH::uint GetNumBroadPhaseLayers() const override { return LAYER_COUNT; }
+    JPH::BroadPhaseLayer GetBroadPhaseLayer(JPH::ObjectLayer layer) const override
+    {
+        return JPH::BroadPhaseLayer(static_cast<JPH::BroadPhaseLayer::Type>(layer));
+    }
+#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+    const char* GetBroadPhaseLayerName(JPH::BroadPhaseLayer layer) const override
+    {
+        return static_cast<JPH::BroadPhaseLayer::Type>(layer) == LAYER_NON_MOVING ? "NonMoving" : "Moving";
+    }
+#endif
+};
+
+class PhysicsWorld::ObjectVsBroadPhaseFilter final : public JPH::ObjectVsBroadPhaseLayerFilter
+{
+  public:
+    bool ShouldCollide(JPH::ObjectLayer layer, JPH::BroadPhaseLayer broadPhaseLayer) const override
+    {
+        return layer == LAYER_MOVING || static_cast<JPH::BroadPhaseLayer::Type>(broadPhaseLayer) == LAYER_MOVING;
+    }
+};
+
+class PhysicsWorld::ObjectLayerPairFilter final : public JPH::ObjectLayerPairFilter
+{
+  public:
+    bool ShouldCollide(JPH::ObjectLayer first, JPH::ObjectLayer second) const override
+    {
+        return first == LAYER_MOVING || second == LAYER_MOVING;
+    }
+};
+
+ThreadPoolJobSystem::ThreadPoolJobSystem(BS::thread_pool<>& threadPool, uint32_t maxJobs, uint32_t maxBarriers)
+    : JobSystemWithBarrier(maxBarriers), threadPool(&threadPool)
+{
+    jobs.Init(maxJobs, maxJobs);
+}
+
+int ThreadPoolJobSystem::GetMaxConcurrency() const
+{
+    // The workers, plus the thread waiting on the barrier
+    return static_cast<int>(threadPool->get_thread_count()) + 1;
+}
+
+JPH::JobHandle ThreadPoolJobSystem::CreateJob(const char* name, JPH::ColorArg color, const JobFunction& function,
+                                              JPH::uint32 numDependencies)
+{
+    // Jobs are freed as soon as they've run, so a full list clears up on its own
+    uint32_t index;
+    while ((index = jobs.ConstructObject(name, color, this, function, numDependencies)) ==
+           JPH::FixedSizeFreeList<Job>::cInvalidObjectIndex) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    Job* job = &jobs.Get(index);
+    // The handle holds a reference, a job without dependencies may run and finish before this returns
+    JobHandle handle(job);
+    if (numDependencies == 0)
+        QueueJob(job);
+    return handle;
+}
+
+void ThreadPoolJobSystem::QueueJob(Job* job)
+{
+    job->AddRef();
+    threadPool->detach_task([job] {
+        job->Execute();
+        job->Release();
+    });
+}
+
+void ThreadPoolJobSystem::QueueJobs(Job** jobs, JPH::uint numJobs)
+{
+    for (JPH::uint i = 0; i < numJobs; ++i)
+        QueueJob(jobs[i]);
+}
+
+void ThreadPoolJobSystem::FreeJob(Job* job)
+{
+    jobs.DestructObject(job);
+}
+
+PhysicsWorld::PhysicsWorld(BS::thread_pool<>& threadPool, uint32_t maxBodies, float timestep,
+                           uint32_t maxStepsPerUpdate)
+    : threadPool(&threadPool), timestep(timestep), maxStepsPerUpdate(std::max(maxStepsPerUpdate, 1u))
+{
+    JPH::RegisterDefaultAllocator();
+    JPH::Factory::sInstance = new JPH::Factory();
+    JPH::RegisterTypes();
+
+    broadPhaseLayers = std::make_unique<BroadPhaseLayers>();
+    objectVsBroadPhaseFilter = std::make_unique<ObjectVsBroadPhaseFilter>();
+    objectLayerPairFilter = std::make_unique<ObjectLayerPairFilter>();
+    tempAllocator = std::make_unique<JPH::TempAllocatorImpl>(PHYSICS_TEMP_MEMORY);
+    jobSystem = std::make_unique<ThreadPoolJobSystem>(threadPool, MAX_PHYSICS_JOBS, MAX_PHYSICS_BARRIERS);
+
+    // Piles of boxes touch a few neighbours each
+    uint32_t maxPairs = std::max(maxBodies * 4, 1024u);
+    system = std::make_unique<JPH::PhysicsSystem>();
+    system->Init(maxBodies, 0, maxPairs, maxPairs, *broadPhaseLayers, *objectVsBroadPhaseFilter,
+                 *objectLayerPairFilter);
+}
+
+PhysicsWorld::~PhysicsWorld()
+{
+    if (stepTask.valid())
+        stepTask.wait();
+    system.reset();
+    jobSystem.reset();
+    tempAllocator.reset();
+
+    JPH::UnregisterTypes();
+    delete JPH::Factory::sInstance;
+    JPH::Factory::sInstance = nullptr;
+}
+
+void PhysicsWorld::addStaticShape(const JPH::Shape* shape, const glm::vec3& position)
+{
+    JPH::BodyCreationSettings settings(shape, toJolt(position), JPH::Quat::sIdentity(), JPH::EMotionType::Static,
+                                       LAYER_NON_MOVING);
+    JPH::BodyID body = system->GetBodyInterface().CreateAndAddBody(settings, JPH::EActivation::DontActivate);
+    if (body.IsInvalid())
+        throw std::runtime_error("physics system is out of bodies!");
+    broadPhaseDirty = true;
+}
+
+void PhysicsWorld::addStaticBox(const glm::vec3& center, const glm::vec3& halfExtent)
+{
+    addStaticShape(createBoxShape(halfExtent), center);
+}
+
+uint32_t PhysicsWorld::addDynamicShape(const JPH::Shape* shape, const glm::vec3& position, const glm::quat& rotation)
+{
+    JPH::Quat joltRotation(rotation.x, rotation.y, rotation.z, rotation.w);
+    JPH::BodyCreationSettings settings(shape, toJolt(position), joltRotation.Normalized(), JPH::EMotionType::Dynamic,
+                                       LAYER_MOVING);
+    JPH::BodyID body = system->GetBodyInterface().CreateAndAddBody(settings, JPH::EActivation::Activate);
+    if (body.IsInvalid())
+        throw std::runtime_error("physics system is out of bodies!");
+    broadPhaseDirty = true;
+
+    bodies.push_back(body);
+    BodyState state{ position, glm::normalize(rotation) };
+    for (auto* states : { &previous, &current, &nextPrevious, &nextCurrent })
+        states->push_back(state);
+    moving.push_back(0);
+    return static_cast<uint32_t>(bodies.size() - 1);
+}
+
+void PhysicsWorld::update(float elapsed)
+{
+    // A task is only started when there is at least one step to take, and then it writes both next states
+    stepCount = 0;
+    if (stepTask.valid()) {
+        stepTask.get();
+        std::swap(previous, nextPrevious);
+        std::swap(current, nextCurrent);
+        stepCount = nextStepCount;
+        stepMs = nextStepMs;
+        activeBodyCount = nextActiveBodyCount;
+        findMovedBodies();
+    }
+    // Without new states the moved bodies stay the same, they still move with alpha
+    alpha = nextAlpha;
+
+    // Time the steps can't catch up on is dropped rather than carried over, a slow frame shouldn't make the next
+    // one slower still
+    accumulator = std::min(accumulator + std::max(elapsed, 0.0f), timestep * static_cast<float>(maxStepsPerUpdate));
+    uint32_t steps = static_cast<uint32_t>(std::floor(accumulator / timestep));
+    accumulator -= static_cast<float>(steps) * timestep;
+    nextAlpha = std::clamp(accumulator / timestep, 0.0f, 1.0f);
+    nextStepCount = steps;
+    if (steps == 0)
+        return;
+
+    if (broadPhaseDirty) {
+        system->OptimizeBroadPhase();
+        broadPhaseDirty = false;
+    }
+    stepTask = threadPool->submit_task([this, steps] {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t s = 0; s < steps; ++s) {
+            if (s + 1 == steps)
+                readStates(nextPrevious);
+            system->Update(timestep, 1, tempAllocator.get(), jobSystem.get());
+        }
+        readStates(nextCurrent);
+        nextActiveBodyCount = system->GetNumActiveBodies(JPH::EBodyType::RigidBody);
+        nextStepMs =
+            std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    });
+}
+
+glm::mat4 PhysicsWorld::getTransform(uint32_t body) const
+{
+    const BodyState& from = previous[body];
+    const BodyState& to = current[body];
+    glm::mat4 transform = glm::mat4_cast(glm::slerp(from.rotation, to.rotation, alpha));
+    transform[3] = glm::vec4(glm::mix(from.position, to.position, alpha), 1.0f);
+    return transform;
+}
+
+void PhysicsWorld::findMovedBodies()
+{
+    movedBodies.clear();
+    for (uint32_t b = 0; b < bodies.size(); ++b) {
+        bool moves = previous[b] != current[b];
+        if (moves || moving[b])
+            movedBodies.push_back(b);
+        moving[b] = moves;
+    }
+}
+
+void PhysicsWorld::readStates(std::vector<BodyState>& states) const
+{
+    // Only ever called with no update running, so the bodies don't need locking
+    const JPH::BodyInterface& bodyInterface = system->GetBodyInterfaceNoLock();
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        JPH::RVec3 position;
+        JPH::Quat rotation;
+        bodyInterface.GetPositionAndRotation(bodies[i], position, rotation);
+        states[i].position = glm::vec3(position.GetX(), position.GetY(), position.GetZ());
+        states[i].rotation = glm::quat(rotation.GetW(), rotation.GetX(), rotation.GetY(), rotation.GetZ());
+    }
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <span>
+#include <vector>
+
+// JoltPhysics, Jolt.h goes first
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/FixedSizeFreeList.h>
+#include <Jolt/Core/JobSystemWithBarrier.h>
+#include <Jolt/Core/TempAllocator.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+
+// thread-pool
+#include <BS_thread_pool.hpp>
+
+// Expects the engine's GLM configuration, include through engine.h
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Scene component of a root node that follows a body of the PhysicsWorld, whose shape is in the node's space
+struct RigidBody {
+    uint32_t body = 0;
+};
+
+// Runs Jolt's jobs on the engine's worker threads instead of a pool of its own. Barriers are Jolt's, a thread waiting
+// on one runs the barrier's jobs itself, so an update started from a worker can't starve the pool.
+class ThreadPoolJobSystem final : public JPH::JobSystemWithBarrier
+{
+  public:
+    ThreadPoolJobSystem(BS::thread_pool<>& threadPool, uint32_t maxJobs, uint32_t maxBarriers);
+
+    int GetMaxConcurrency() const override;
+    JobHandle CreateJob(const char* name, JPH::ColorArg color, const JobFunction& function,
+                        JPH::uint32 numDependencies = 0) override;
+
+  protected:
+    void QueueJob(Job* job) override;
+    void QueueJobs(Job** jobs, JPH::uint numJobs) override;
+    void FreeJob(Job* job) override;
+
+  private:
+    BS::thread_pool<>* threadPool;
+    JPH::FixedSizeFreeList<Job> jobs;
+};
+
+// A Jolt PhysicsSystem stepped at a fixed timestep on the workers, asynchronously from the frame: update() collects the
+// steps the previous call started and starts the next ones, so the render thread only waits if they haven't finished
+// a frame later. Body transforms are published in pairs, the two most recent steps, and getTransform() interpolates
+// between them by how far the clock has run past the older one. That puts what is drawn a step or so behind the
+// simulation, in exchange for motion that doesn't judder when frames and steps don't line up.
+// Registers Jolt's allocator, factory and types for as long as it lives, only one may exist at a time.
+class PhysicsWorld
+{
+  public:
+    PhysicsWorld(BS::thread_pool<>& threadPool, uint32_t maxBodies, float timestep, uint32_t maxStepsPerUpdate);
+    ~PhysicsWorld();
+    PhysicsWorld(const PhysicsWorld&) = delete;
+    PhysicsWorld& operator=(const PhysicsWorld&) = delete;
+
+    // Bodies can only be added between updates, before the first one is best since the broad phase is optimized then
+    void addStaticShape(const JPH::Shape* shape, const glm::vec3& position);
+    void addStaticBox(const glm::vec3& center, const glm::vec3& halfExtent);
+    // Returns the index getTransform() takes, throws when the system is full. The shape has to be one a dynamic body
+    // can have, so no mesh shapes.
+    uint32_t addDynamicShape(const JPH::Shape* shape, const glm::vec3& position, const glm::quat& rotation);
+
+    // Call once per frame with the seconds since the last call
+    void update(float elapsed);
+    [[nodiscard]] glm::mat4 getTransform(uint32_t body) const;
+    // Bodies whose getTransform() may differ from the last update's: those that moved between the published states,
+    // and those that did in the update before, which have to be set once more where they came to rest. Sleeping
+    // bodies are left out.
+    [[nodiscard]] std::span<const uint32_t> getMovedBodies() const { return movedBodies; }
+
+    [[nodiscard]] uint32_t getBodyCount() const { return static_cast<uint32_t>(bodies.size()); }
+    [[nodiscard]] uint32_t getActiveBodyCount() const { return activeBodyCount; }
+    // Of the last published update
+    [[nodiscard]] uint32_t getStepCount() const { return stepCount; }
+    [[nodiscard]] double getStepMs() const { return stepMs; }
+
+  private:
+    struct BodyState {
+        glm::vec3 position;
+        glm::quat rotation;
+
+        bool operator==(const BodyState&) const = default;
+    };
+
+    // Layer tables the PhysicsSystem keeps pointers to
+    class BroadPhaseLayers;
+    class ObjectVsBroadPhaseFilter;
+    class ObjectLayerPairFilter;
+    std::unique_ptr<BroadPhaseLayers> broadPhaseLayers;
+    std::unique_ptr<ObjectVsBroadPhaseFilter> objectVsBroadPhaseFilter;
+    std::unique_ptr<ObjectLayerPairFilter> objectLayerPairFilter;
+
+    std::unique_ptr<JPH::TempAllocatorImpl> tempAllocator;
+    std::unique_ptr<ThreadPoolJobSystem> jobSystem;
+    std::unique_ptr<JPH::PhysicsSystem> system;
+    BS::thread_pool<>* threadPool;
+    float timestep;
+    uint32_t maxStepsPerUpdate;
+
+    std::vector<JPH::BodyID> bodies;
+    // Published, read by getTransform()
+    std::vector<BodyState> previous;
+    std::vector<BodyState> current;
+    float alpha = 0.0f;
+    std::vector<uint32_t> movedBodies;
+    // Indexed by body, whether its published states differ
+    std::vector<uint8_t> moving;
+    uint32_t stepCount = 0;
+    double stepMs = 0.0;
+    uint32_t activeBodyCount = 0;
+
+    // Written by the steps in flight, swapped in when they're collected
+    std::future<void> stepTask;
+    std::vector<BodyState> nextPrevious;
+    std::vector<BodyState> nextCurrent;
+    uint32_t nextStepCount = 0;
+    double nextStepMs = 0.0;
+    uint32_t nextActiveBodyCount = 0;
+    float accumulator = 0.0f;
+    float nextAlpha = 0.0f;
+    bool broadPhaseDirty = false;
+
+    void readStates(std::vector<BodyState>& states) const;
+    void findMovedBodies();
+};
@@ -0,0 +1,73 @@
+#include <pipeline_cache.h>
+
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+PipelineCache::PipelineCache(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice,
+                             const std::filesystem::path& directory)
+    : properties(physicalDevice.getProperties())
+{
+    std::string uuid;
+    for (uint8_t byte : properties.pipelineCacheUUID)
+        uuid += std::format("{:02x}", byte);
+    path = directory / std::format("pipelines_{:04x}_{:04x}_{}.bin", properties.vendorID, properties.deviceID, uuid);
+
+    std::vector<char> data;
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (file.is_open()) {
+        data.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!file || !isCompatible(data))
+            data.clear();
+    }
+    warm = !data.empty();
+
+    vk::PipelineCacheCreateInfo createInfo{};
+    createInfo.setInitialDataSize(data.size()).setPInitialData(data.data());
+    cache = vk::raii::PipelineCache(device, createInfo);
+}
+
+void PipelineCache::save() const
+{
+    if (!*cache)
+        return;
+
+    std::vector<uint8_t> data = cache.getData();
+    std::filesystem::create_directories(path.parent_path());
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            throw std::runtime_error("failed to open " + tempPath.string());
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!file)
+            throw std::runtime_error("failed to write " + tempPath.string());
+    }
+    std::filesystem::rename(tempPath, path);
+}
+
+bool PipelineCache::isCompatible(const std::vector<char>& data) const
+{
+    // VkPipelineCacheHeaderVersionOne, which every implementation has to put first
+    struct Header {
+        uint32_t headerSize;
+        uint32_t headerVersion;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+    };
+    if (data.size() < sizeof(Header))
+        return false;
+
+    Header header{};
+    memcpy(&header, data.data(), sizeof(Header));
+    return header.headerSize >= sizeof(Header) && header.headerSize <= data.size() &&
+           header.headerVersion == static_cast<uint32_t>(vk::PipelineCacheHeaderVersion::eOne) &&
+           header.vendorID == properties.vendorID && header.deviceID == properties.deviceID &&
+           memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+}
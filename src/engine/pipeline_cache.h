@@ -0,0 +1,36 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+// Vulkan
+#include <vulkan/vulkan_raii.hpp>
+
+// A VkPipelineCache persisted between runs. The file name is keyed by vendor, device and pipeline cache UUID, and
+// the blob's header is checked against the device before it's handed to the driver, so a driver update or a
+// different GPU starts from an empty cache instead of feeding the driver stale data.
+class PipelineCache
+{
+  public:
+    PipelineCache(std::nullptr_t) {}
+    PipelineCache(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice,
+                  const std::filesystem::path& directory);
+
+    vk::PipelineCache operator*() const { return *cache; }
+    // vk::raii::Pipeline's constructors take the RAII wrapper
+    [[nodiscard]] const vk::raii::PipelineCache& getCache() const { return cache; }
+    // Whether valid data for this device was loaded from disk
+    [[nodiscard]] bool isWarm() const { return warm; }
+    [[nodiscard]] const std::filesystem::path& getPath() const { return path; }
+
+    // Writes the cache to a temporary file and renames it over the old one, so a crash never leaves a torn file
+    void save() const;
+
+  private:
+    vk::raii::PipelineCache cache = nullptr;
+    vk::PhysicalDeviceProperties properties{};
+    std::filesystem::path path;
+    bool warm = false;
+
+    [[nodiscard]] bool isCompatible(const std::vector<char>& data) const;
+};
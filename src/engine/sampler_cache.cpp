@@ -0,0 +1,48 @@
+#include <sampler_cache.h>
+
+#include <algorithm>
+#include <functional>
+
+SamplerCache::SamplerCache(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice)
+    : device(&device), maxAnisotropy(physicalDevice.getProperties().limits.maxSamplerAnisotropy)
+{
+}
+
+vk::Sampler SamplerCache::get(const SamplerState& state)
+{
+    auto it = samplers.find(state);
+    if (it != samplers.end())
+        return *it->second;
+
+    float anisotropy = std::min(state.maxAnisotropy, maxAnisotropy);
+    vk::SamplerCreateInfo samplerInfo{};
+    samplerInfo.setMagFilter(state.magFilter)
+        .setMinFilter(state.minFilter)
+        .setMipmapMode(state.mipmapMode)
+        .setAddressModeU(state.addressModeU)
+        .setAddressModeV(state.addressModeV)
+        .setAddressModeW(state.addressModeW)
+        .setMipLodBias(0.0f)
+        .setMinLod(0.0f)
+        .setMaxLod(VK_LOD_CLAMP_NONE)
+        .setAnisotropyEnable(anisotropy > 1.0f ? vk::True : vk::False)
+        .setMaxAnisotropy(std::max(anisotropy, 1.0f))
+        .setCompareEnable(vk::False)
+        .setCompareOp(vk::CompareOp::eAlways);
+    auto [inserted, _] = samplers.emplace(state, vk::raii::Sampler(*device, samplerInfo));
+    return *inserted->second;
+}
+
+size_t SamplerCache::StateHash::operator()(const SamplerState& state) const
+{
+    size_t hash = 0;
+    auto combine = [&](size_t value) { hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2); };
+    combine(static_cast<size_t>(state.magFilter));
+    combine(static_cast<size_t>(state.minFilter));
+    combine(static_cast<size_t>(state.mipmapMode));
+    combine(static_cast<size_t>(state.addressModeU));
+    combine(static_cast<size_t>(state.addressModeV));
+    combine(static_cast<size_t>(state.addressModeW));
+    combine(std::hash<float>{}(state.maxAnisotropy));
+    return hash;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+
+// Vulkan
+#include <vulkan/vulkan_raii.hpp>
+
+// The sampler state a texture asks for. LODs are never clamped by the sampler: each texture's image view covers
+// exactly the mips it has, so one sampler serves textures with any number of levels.
+struct SamplerState {
+    vk::Filter magFilter = vk::Filter::eLinear;
+    vk::Filter minFilter = vk::Filter::eLinear;
+    vk::SamplerMipmapMode mipmapMode = vk::SamplerMipmapMode::eLinear;
+    vk::SamplerAddressMode addressModeU = vk::SamplerAddressMode::eRepeat;
+    vk::SamplerAddressMode addressModeV = vk::SamplerAddressMode::eRepeat;
+    vk::SamplerAddressMode addressModeW = vk::SamplerAddressMode::eRepeat;
+    // 0 turns anisotropic filtering off, anything above the device limit is clamped to it
+    float maxAnisotropy = 16.0f;
+
+    bool operator==(const SamplerState&) const = default;
+};
+
+// One VkSampler per distinct SamplerState, created on first use and kept until the cache is destroyed, so a
+// descriptor written with a cached sampler never outlives it
+class SamplerCache
+{
+  public:
+    SamplerCache(std::nullptr_t) {}
+    SamplerCache(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice);
+
+    vk::Sampler get(const SamplerState& state);
+    [[nodiscard]] size_t getCount() const { return samplers.size(); }
+    void clear() { samplers.clear(); }
+
+  private:
+    struct StateHash {
+        size_t operator()(const SamplerState& state) const;
+    };
+
+    const vk::raii::Device* device = nullptr;
+    float maxAnisotropy = 1.0f;
+    std::unordered_map<SamplerState, vk::raii::Sampler, StateHash> samplers;
+};
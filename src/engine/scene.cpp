@@ -0,0 +1,121 @@
+#include <scene.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+entt::entity Scene::createNode(entt::entity parent, const glm::mat4& local)
+{
+    entt::entity node = registry.create();
+    SceneNode& sceneNode = registry.emplace<SceneNode>(node);
+    sceneNode.parent = parent;
+    sceneNode.depth = parent == entt::null ? 0 : registry.get<SceneNode>(parent).depth + 1;
+    registry.emplace<LocalTransform>(node, local);
+    registry.emplace<WorldTransform>(node);
+    nodeCount++;
+    dirtyNodes.push_back(node);
+    unsorted = true;
+    return node;
+}
+
+void Scene::setLocalTransform(entt::entity node, const glm::mat4& local)
+{
+    registry.get<LocalTransform>(node).matrix = local;
+    SceneNode& sceneNode = registry.get<SceneNode>(node);
+    if (!sceneNode.dirty) {
+        sceneNode.dirty = true;
+        dirtyNodes.push_back(node);
+    }
+}
+
+uint32_t Scene::update()
+{
+    if (dirtyNodes.empty() && changedRanges.empty())
+        return 0;
+    if (unsorted) {
+        sortNodes();
+        unsorted = false;
+    }
+
+    // The pools are sorted alike, so the same index is the same entity in all three
+    auto nodes = registry.storage<SceneNode>().begin();
+    auto locals = registry.storage<LocalTransform>().begin();
+    auto worlds = registry.storage<WorldTransform>().begin();
+    for (auto [begin, end] : changedRanges)
+        for (uint32_t i = begin; i < end; i++)
+            worlds[i].changed = false;
+    changedRanges.clear();
+
+    dirtyIndices.clear();
+    for (entt::entity entity : dirtyNodes) {
+        SceneNode& node = registry.get<SceneNode>(entity);
+        node.dirty = false;
+        dirtyIndices.push_back(node.index);
+    }
+    dirtyNodes.clear();
+    std::ranges::sort(dirtyIndices);
+
+    // Each moved node's subtree is recomputed as a run, parents before children. A node inside a run already done
+    // was covered by it, and a parent outside the run did not move, so its world transform is current.
+    uint32_t changedCount = 0;
+    uint32_t done = 0;
+    for (uint32_t begin : dirtyIndices) {
+        if (begin < done)
+            continue;
+        uint32_t end = begin + nodes[begin].subtreeSize;
+        for (uint32_t i = begin; i < end; i++) {
+            const SceneNode& node = nodes[i];
+            const glm::mat4& local = locals[i].matrix;
+            WorldTransform& world = worlds[i];
+            world.matrix = node.parentIndex == SceneNode::noParent ? local : worlds[node.parentIndex].matrix * local;
+            world.changed = true;
+        }
+        changedRanges.emplace_back(begin, end);
+        changedCount += end - begin;
+        done = end;
+    }
+    return changedCount;
+}
+
+void Scene::sortNodes()
+{
+    // Depth order first, which puts every parent ahead of its children
+    registry.sort<SceneNode>([](const SceneNode& lhs, const SceneNode& rhs) { return lhs.depth < rhs.depth; });
+    auto& nodes = registry.storage<SceneNode>();
+    std::vector<entt::entity> byDepth;
+    byDepth.reserve(nodes.size());
+    for (auto [entity, node] : nodes.each()) {
+        node.subtreeSize = 1;
+        byDepth.push_back(entity);
+    }
+
+    // Subtree sizes bottom up
+    for (auto it = byDepth.rbegin(); it != byDepth.rend(); ++it) {
+        const SceneNode& node = nodes.get(*it);
+        if (node.parent != entt::null)
+            nodes.get(node.parent).subtreeSize += node.subtreeSize;
+    }
+
+    // Then indices top down: each node takes the next free slot of its parent's subtree, and its own children follow
+    // it, which lays the pools out depth-first
+    std::unordered_map<entt::entity, uint32_t> nextSlot;
+    nextSlot.reserve(byDepth.size());
+    uint32_t nextRoot = 0;
+    for (entt::entity entity : byDepth) {
+        SceneNode& node = nodes.get(entity);
+        if (node.parent == entt::null) {
+            node.index = nextRoot;
+            node.parentIndex = SceneNode::noParent;
+            nextRoot += node.subtreeSize;
+        } else {
+            uint32_t& slot = nextSlot.at(node.parent);
+            node.index = slot;
+            node.parentIndex = nodes.get(node.parent).index;
+            slot += node.subtreeSize;
+        }
+        nextSlot[entity] = node.index + 1;
+    }
+
+    registry.sort<SceneNode>([](const SceneNode& lhs, const SceneNode& rhs) { return lhs.index < rhs.index; });
+    registry.sort<LocalTransform, SceneNode>();
+    registry.sort<WorldTransform, SceneNode>();
+}
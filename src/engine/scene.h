@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// EnTT
+#include <entt/entt.hpp>
+
+// Expects the engine's GLM configuration, include through engine.h
+#include <glm/glm.hpp>
+
+// Where a node sits in the hierarchy. depth is 0 for roots and one more than the parent's otherwise.
+struct SceneNode {
+    static constexpr uint32_t noParent = std::numeric_limits<uint32_t>::max();
+
+    entt::entity parent = entt::null;
+    uint32_t depth = 0;
+    // Position in the sorted pools and the parent's, set when the pools are sorted. The node's subtree is
+    // [index, index + subtreeSize).
+    uint32_t index = 0;
+    uint32_t parentIndex = noParent;
+    uint32_t subtreeSize = 1;
+    // The local transform changed since the last update
+    bool dirty = true;
+};
+
+// Relative to the parent
+struct LocalTransform {
+    glm::mat4 matrix{ 1.0f };
+};
+
+struct WorldTransform {
+    glm::mat4 matrix{ 1.0f };
+    // Recomputed by the last update, because the node or one of its ancestors moved
+    bool changed = false;
+};
+
+// The engine objects [firstObject, firstObject + objectCount) a node draws, one per cooked mesh
+struct MeshInstance {
+    uint32_t firstObject = 0;
+    uint32_t objectCount = 0;
+};
+
+// A transform hierarchy over an EnTT registry. SceneNode, LocalTransform and WorldTransform live in pools of their own
+// that are kept sorted depth-first and in the same order, so every subtree is one contiguous run of the pools behind
+// its root. Propagating world transforms walks the runs of the moved nodes by index, with the parent addressed by its
+// index too, and never touches the clean subtrees in between. A frame where nothing moved skips the pass.
+class Scene
+{
+  public:
+    entt::entity createNode(entt::entity parent, const glm::mat4& local);
+    void setLocalTransform(entt::entity node, const glm::mat4& local);
+
+    // Recomputes the world transform of every moved node and its descendants and flags them changed. Returns how
+    // many were, the flags are valid until the next update.
+    uint32_t update();
+
+    [[nodiscard]] entt::registry& getRegistry() { return registry; }
+    [[nodiscard]] const entt::registry& getRegistry() const { return registry; }
+    [[nodiscard]] size_t getNodeCount() const { return nodeCount; }
+
+  private:
+    entt::registry registry;
+    size_t nodeCount = 0;
+    // Nodes created since the pools were last sorted
+    bool unsorted = false;
+    std::vector<entt::entity> dirtyNodes;
+    // Reused by update, the pool indices of dirtyNodes
+    std::vector<uint32_t> dirtyIndices;
+    // The [begin, end) runs the last update flagged changed, which the next one has to clear
+    std::vector<std::pair<uint32_t, uint32_t>> changedRanges;
+
+    void sortNodes();
+};
@@ -0,0 +1,195 @@
+#include <engine.h>
+
+#include <chrono>
+#include <numeric>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define GNVE_CULL_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GNVE_CULL_SSE2
+#endif
+
+void SceneBvh::build(std::span<const Aabb> bounds)
+{
+    uint32_t count = static_cast<uint32_t>(bounds.size());
+    objectBounds.assign(bounds.begin(), bounds.end());
+    objectIds.resize(count);
+    std::iota(objectIds.begin(), objectIds.end(), 0u);
+    objectSlots.resize(count);
+    objectLeaves.resize(count);
+
+    nodes.clear();
+    if (count == 0)
+        return;
+    nodes.reserve(4 * (count / LEAF_SIZE + 1));
+    nodes.push_back(Node{});
+    subdivide(0, 0, count);
+
+    // Padding lets the batch test load a full register at the end of the last leaf
+    for (auto* soa : { &minX, &minY, &minZ, &maxX, &maxY, &maxZ })
+        soa->assign(count + SIMD_PADDING, 0.0f);
+    for (uint32_t slot = 0; slot < count; ++slot) {
+        objectSlots[objectIds[slot]] = slot;
+        writeSlot(slot, objectBounds[objectIds[slot]]);
+    }
+    for (uint32_t n = 0; n < nodes.size(); ++n) {
+        if (nodes[n].left != UINT32_MAX)
+            continue;
+        for (uint32_t slot = nodes[n].first; slot < nodes[n].first + nodes[n].count; ++slot)
+            objectLeaves[objectIds[slot]] = n;
+    }
+}
+
+void SceneBvh::update(uint32_t object, const Aabb& bounds)
+{
+    objectBounds[object] = bounds;
+    writeSlot(objectSlots[object], bounds);
+
+    for (uint32_t n = objectLeaves[object]; n != UINT32_MAX; n = nodes[n].parent) {
+        Node& node = nodes[n];
+        Aabb refit{};
+        if (node.left == UINT32_MAX) {
+            for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+                refit.expand(objectBounds[objectIds[slot]]);
+        } else {
+            refit.expand(nodes[node.left].bounds);
+            refit.expand(nodes[node.left + 1].bounds);
+        }
+        node.bounds = refit;
+    }
+}
+
+CullStats SceneBvh::cull(const Frustum& frustum, std::vector<uint32_t>& visible) const
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    CullStats stats{};
+    size_t visibleBefore = visible.size();
+
+    if (!nodes.empty()) {
+        // Median splits keep the depth around log2(objects / LEAF_SIZE)
+        std::array<uint32_t, 64> stack;
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0) {
+            const Node& node = nodes[stack[--stackSize]];
+            stats.nodesVisited++;
+
+            Containment containment = frustum.classify(node.bounds);
+            if (containment == Containment::Outside)
+                continue;
+            if (containment == Containment::Inside) {
+                visible.insert(visible.end(), objectIds.begin() + node.first,
+                               objectIds.begin() + node.first + node.count);
+            } else if (node.left == UINT32_MAX) {
+                stats.tested += node.count;
+                testObjects(frustum, node.first, node.count, visible);
+            } else {
+                stack[stackSize++] = node.left;
+                stack[stackSize++] = node.left + 1;
+            }
+        }
+    }
+
+    stats.visible = static_cast<uint32_t>(visible.size() - visibleBefore);
+    stats.culled = static_cast<uint32_t>(objectIds.size()) - stats.visible;
+    stats.micros =
+        std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+    return stats;
+}
+
+void SceneBvh::subdivide(uint32_t nodeIndex, uint32_t first, uint32_t count)
+{
+    Aabb bounds{};
+    Aabb centroids{};
+    for (uint32_t slot = first; slot < first + count; ++slot) {
+        const Aabb& box = objectBounds[objectIds[slot]];
+        bounds.expand(box);
+        centroids.expand((box.min + box.max) * 0.5f);
+    }
+    nodes[nodeIndex].bounds = bounds;
+    nodes[nodeIndex].first = first;
+    nodes[nodeIndex].count = count;
+    if (count <= LEAF_SIZE)
+        return;
+
+    glm::vec3 extent = centroids.max - centroids.min;
+    int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+    uint32_t half = count / 2;
+    std::nth_element(objectIds.begin() + first, objectIds.begin() + first + half, objectIds.begin() + first + count,
+                     [&](uint32_t a, uint32_t b) {
+                         return objectBounds[a].min[axis] + objectBounds[a].max[axis] <
+                                objectBounds[b].min[axis] + objectBounds[b].max[axis];
+                     });
+
+    uint32_t left = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(Node{ {}, 0, 0, UINT32_MAX, nodeIndex });
+    nodes.push_back(Node{ {}, 0, 0, UINT32_MAX, nodeIndex });
+    nodes[nodeIndex].left = left;
+    subdivide(left, first, half);
+    subdivide(left + 1, first + half, count - half);
+}
+
+void SceneBvh::writeSlot(uint32_t slot, const Aabb& bounds)
+{
+    minX[slot] = bounds.min.x;
+    minY[slot] = bounds.min.y;
+    minZ[slot] = bounds.min.z;
+    maxX[slot] = bounds.max.x;
+    maxY[slot] = bounds.max.y;
+    maxZ[slot] = bounds.max.z;
+}
+
+void SceneBvh::testObjects(const Frustum& frustum, uint32_t first, uint32_t count,
+                           std::vector<uint32_t>& visible) const
+{
+    // Same test as Frustum::intersects, one plane at a time across a batch of boxes. The plane is constant across
+    // the batch, so picking the corner furthest along its normal is a per-plane choice between the min and max arrays.
+#if defined(GNVE_CULL_AVX)
+    constexpr uint32_t WIDTH = 8;
+    for (uint32_t base = first; base < first + count; base += WIDTH) {
+        __m256 outside = _mm256_setzero_ps();
+        for (auto& plane : frustum.planes) {
+            __m256 x = _mm256_loadu_ps((plane.x >= 0.0f ? maxX : minX).data() + base);
+            __m256 y = _mm256_loadu_ps((plane.y >= 0.0f ? maxY : minY).data() + base);
+            __m256 z = _mm256_loadu_ps((plane.z >= 0.0f ? maxZ : minZ).data() + base);
+            __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane.x)), _mm256_mul_ps(y, _mm256_set1_ps(plane.y))),
+                _mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+        uint32_t lanes = std::min(WIDTH, first + count - base);
+        uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & ((1u << lanes) - 1);
+        for (uint32_t lane = 0; lane < lanes; ++lane) {
+            if (mask & (1u << lane))
+                visible.push_back(objectIds[base + lane]);
+        }
+    }
+#elif defined(GNVE_CULL_SSE2)
+    constexpr uint32_t WIDTH = 4;
+    for (uint32_t base = first; base < first + count; base += WIDTH) {
+        __m128 outside = _mm_setzero_ps();
+        for (auto& plane : frustum.planes) {
+            __m128 x = _mm_loadu_ps((plane.x >= 0.0f ? maxX : minX).data() + base);
+            __m128 y = _mm_loadu_ps((plane.y >= 0.0f ? maxY : minY).data() + base);
+            __m128 z = _mm_loadu_ps((plane.z >= 0.0f ? maxZ : minZ).data() + base);
+            __m128 distance =
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+                           _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+        }
+        uint32_t lanes = std::min(WIDTH, first + count - base);
+        uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & ((1u << lanes) - 1);
+        for (uint32_t lane = 0; lane < lanes; ++lane) {
+            if (mask & (1u << lane))
+                visible.push_back(objectIds[base + lane]);
+        }
+    }
+#else
+    for (uint32_t slot = first; slot < first + count; ++slot) {
+        if (frustum.intersects(objectBounds[objectIds[slot]]))
+            visible.push_back(objectIds[slot]);
+    }
+#endif
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <culling.h>
+
+struct CullStats {
+    // Objects that went through the per-object plane test (the rest were decided by a node)
+    uint32_t tested = 0;
+    uint32_t visible = 0;
+    uint32_t culled = 0;
+    uint32_t nodesVisited = 0;
+    double micros = 0.0;
+};
+
+// Median-split bounding volume hierarchy over object AABBs. Leaf bounds are also kept as SoA arrays in tree order
+// so a leaf can be plane-tested several objects at a time (AVX when the build enables it, SSE2 otherwise).
+// Moving an object only refits the nodes on its path to the root; rebuild when the scene changes a lot.
+class SceneBvh
+{
+  public:
+    void build(std::span<const Aabb> objectBounds);
+    void update(uint32_t object, const Aabb& bounds);
+    // Appends the indices of the objects intersecting the frustum to visible
+    CullStats cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+
+    [[nodiscard]] size_t getNodeCount() const { return nodes.size(); }
+    [[nodiscard]] size_t getObjectCount() const { return objectIds.size(); }
+
+  private:
+    struct Node {
+        Aabb bounds;
+        // Objects under this node are objectIds[first, first + count)
+        uint32_t first = 0;
+        uint32_t count = 0;
+        // Children are left and left + 1; UINT32_MAX for leaves
+        uint32_t left = UINT32_MAX;
+        uint32_t parent = UINT32_MAX;
+    };
+
+    static constexpr uint32_t LEAF_SIZE = 8;
+    static constexpr uint32_t SIMD_PADDING = 8;
+
+    std::vector<Node> nodes;
+    std::vector<Aabb> objectBounds;
+    // Tree order -> object, object -> tree order, object -> leaf node
+    std::vector<uint32_t> objectIds;
+    std::vector<uint32_t> objectSlots;
+    std::vector<uint32_t> objectLeaves;
+    std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+
+    void subdivide(uint32_t nodeIndex, uint32_t first, uint32_t count);
+    void writeSlot(uint32_t slot, const Aabb& bounds);
+    void testObjects(const Frustum& frustum, uint32_t first, uint32_t count, std::vector<uint32_t>& visible) const;
+};
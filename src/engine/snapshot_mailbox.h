@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Hands the latest of a stream of values from one producer thread to one consumer thread, without locks and without
+// either side ever waiting on the other. Of the three slots the producer fills one, the consumer reads another and
+// the third holds the latest published value; publishing and taking each swap a slot with that one in a single atomic
+// exchange. A consumer slower than the producer skips values, one that is faster keeps reading the same one.
+// Slots are reused, so a T that holds containers keeps their capacity from one round to the next.
+template <typename T> class SnapshotMailbox
+{
+  public:
+    // Producer side: the slot to fill, holding whatever was written to it three publishes ago
+    [[nodiscard]] T& beginWrite() { return slots[writeSlot]; }
+    void publish()
+    {
+        uint8_t previous = latest.exchange(static_cast<uint8_t>(writeSlot | FRESH), std::memory_order_acq_rel);
+        writeSlot = previous & INDEX_MASK;
+    }
+
+    // Consumer side: takes the latest published value if it hasn't been taken yet, returns whether it did
+    bool acquire()
+    {
+        if ((latest.load(std::memory_order_relaxed) & FRESH) == 0)
+            return false;
+        uint8_t previous = latest.exchange(readSlot, std::memory_order_acq_rel);
+        readSlot = previous & INDEX_MASK;
+        return true;
+    }
+    // The value acquire() last took, valid until the next acquire()
+    [[nodiscard]] const T& read() const { return slots[readSlot]; }
+
+  private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH = 0x4;
+
+    std::array<T, 3> slots{};
+    // Slot index of the latest value, with FRESH set until the consumer takes it
+    std::atomic<uint8_t> latest{ 1 };
+    // Only ever touched by their own side
+    uint8_t writeSlot = 0;
+    uint8_t readSlot = 2;
+};
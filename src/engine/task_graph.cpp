@@ -0,0 +1,166 @@
+#include <task_graph.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+TaskGraph::TaskId TaskGraph::add(std::string name, std::function<void()> work,
+                                 std::initializer_list<TaskId> dependencies, TaskAffinity affinity)
+{
+    TaskId id = static_cast<TaskId>(tasks.size());
+    for (TaskId dependency : dependencies) {
+        if (dependency >= id)
+            throw std::runtime_error("task graph dependency added after its dependent!");
+    }
+    Task& task = tasks.emplace_back();
+    task.name = std::move(name);
+    task.work = std::move(work);
+    task.affinity = affinity;
+    task.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    for (TaskId dependency : dependencies)
+        tasks[dependency].successors.push_back(id);
+    return id;
+}
+
+TaskGraph::TaskId TaskGraph::addParallelFor(std::string name, std::function<size_t()> count, size_t grain,
+                                            std::function<void(size_t begin, size_t end)> body,
+                                            std::initializer_list<TaskId> dependencies)
+{
+    TaskId id = add(std::move(name), nullptr, dependencies);
+    tasks[id].count = std::move(count);
+    tasks[id].body = std::move(body);
+    tasks[id].grain = std::max<size_t>(grain, 1);
+    return id;
+}
+
+void TaskGraph::run()
+{
+    runStart = std::chrono::high_resolution_clock::now();
+    error = nullptr;
+    mainQueue.clear();
+    remaining = tasks.size();
+    for (Task& task : tasks)
+        task.pending = task.dependencyCount;
+    for (TaskId id = 0; id < tasks.size(); ++id) {
+        if (tasks[id].dependencyCount == 0)
+            schedule(id);
+    }
+
+    std::unique_lock lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] { return remaining == 0 || !mainQueue.empty(); });
+        if (mainQueue.empty())
+            break;
+        TaskId id = mainQueue.back();
+        mainQueue.pop_back();
+        lock.unlock();
+        // Only workers carry on with a successor, one made ready here goes through schedule() like any other
+        TaskId next = execute(id);
+        if (next != UINT32_MAX)
+            schedule(next);
+        lock.lock();
+    }
+    runMs = now();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+double TaskGraph::now() const
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - runStart).count();
+}
+
+void TaskGraph::schedule(TaskId task)
+{
+    if (tasks[task].affinity == TaskAffinity::Main) {
+        {
+            std::lock_guard lock(mutex);
+            mainQueue.push_back(task);
+        }
+        wake.notify_one();
+        return;
+    }
+    threadPool->detach_task([this, task] { runOnWorker(task); });
+}
+
+void TaskGraph::runOnWorker(TaskId task)
+{
+    while (task != UINT32_MAX)
+        task = execute(task);
+}
+
+TaskGraph::TaskId TaskGraph::execute(TaskId id)
+{
+    Task& task = tasks[id];
+    task.startMs = now();
+    if (!task.body) {
+        try {
+            task.work();
+        } catch (...) {
+            fail();
+        }
+        return finish(id);
+    }
+
+    size_t count = 0;
+    try {
+        count = task.count();
+    } catch (...) {
+        fail();
+    }
+    // The caller runs the first chunk itself; the last chunk to finish, wherever it ran, finishes the task
+    size_t chunks = std::max<size_t>((count + task.grain - 1) / task.grain, 1);
+    size_t chunkSize = (count + chunks - 1) / chunks;
+    task.chunksLeft = chunks;
+    for (size_t c = 1; c < chunks; ++c) {
+        size_t begin = c * chunkSize;
+        size_t end = std::min(begin + chunkSize, count);
+        threadPool->detach_task([this, id, begin, end] {
+            runChunk(id, begin, end);
+            if (tasks[id].chunksLeft.fetch_sub(1) == 1)
+                runOnWorker(finish(id));
+        });
+    }
+    runChunk(id, 0, std::min(chunkSize, count));
+    if (task.chunksLeft.fetch_sub(1) == 1)
+        return finish(id);
+    return UINT32_MAX;
+}
+
+void TaskGraph::runChunk(TaskId task, size_t begin, size_t end)
+{
+    if (begin >= end)
+        return;
+    try {
+        tasks[task].body(begin, end);
+    } catch (...) {
+        fail();
+    }
+}
+
+TaskGraph::TaskId TaskGraph::finish(TaskId id)
+{
+    Task& task = tasks[id];
+    task.endMs = now();
+    TaskId next = UINT32_MAX;
+    for (TaskId successor : task.successors) {
+        if (tasks[successor].pending.fetch_sub(1) != 1)
+            continue;
+        if (next == UINT32_MAX && tasks[successor].affinity == TaskAffinity::Worker)
+            next = successor;
+        else
+            schedule(successor);
+    }
+    // Successors are out before this task counts as done, so run() can't return with any of them left. Notified
+    // under the lock, run() may return and the next run() start as soon as it's released.
+    std::lock_guard lock(mutex);
+    if (--remaining == 0)
+        wake.notify_one();
+    return next;
+}
+
+void TaskGraph::fail()
+{
+    std::lock_guard lock(mutex);
+    if (!error)
+        error = std::current_exception();
+}
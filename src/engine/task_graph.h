@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// thread-pool
+#include <BS_thread_pool.hpp>
+
+// Where a task may run. Main tasks run on the thread that called run(), for work that has to stay there (GLFW,
+// ImGui, recording into a command buffer only that thread touches); everything else goes to the workers.
+enum class TaskAffinity {
+    Worker,
+    Main,
+};
+
+// A graph of tasks with dependencies, built once and run as often as needed, e.g. once per frame. Tasks whose
+// dependencies have all finished are started right away, so independent ones overlap across cores. A worker that
+// finishes a task carries on with a successor it made ready itself instead of queueing it, which keeps chains of
+// stages on one warm core. Parallel-for tasks split their range into chunks of at least their grain size and finish
+// when the last chunk does.
+// Runs on an existing BS::thread_pool, whose shared queue stands in for per-worker deques.
+class TaskGraph
+{
+  public:
+    using TaskId = uint32_t;
+
+    explicit TaskGraph(BS::thread_pool<>& threadPool) : threadPool(&threadPool) {}
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    // Dependencies have to be added first, so a graph can't have cycles
+    TaskId add(std::string name, std::function<void()> work, std::initializer_list<TaskId> dependencies = {},
+               TaskAffinity affinity = TaskAffinity::Worker);
+    // count is asked for when the task starts, so it may depend on what the dependencies produced. body gets
+    // [begin, end) ranges of it.
+    TaskId addParallelFor(std::string name, std::function<size_t()> count, size_t grain,
+                          std::function<void(size_t begin, size_t end)> body,
+                          std::initializer_list<TaskId> dependencies = {});
+
+    // Runs every task once and returns when all have finished, running main tasks on this thread meanwhile.
+    // Rethrows the first exception a task threw, the tasks that depend on it still run.
+    void run();
+
+    [[nodiscard]] size_t getTaskCount() const { return tasks.size(); }
+    [[nodiscard]] const std::string& getName(TaskId task) const { return tasks[task].name; }
+    // Of the last run, in milliseconds from its start
+    [[nodiscard]] double getStartMs(TaskId task) const { return tasks[task].startMs; }
+    [[nodiscard]] double getEndMs(TaskId task) const { return tasks[task].endMs; }
+    [[nodiscard]] double getRunMs() const { return runMs; }
+
+  private:
+    struct Task {
+        std::string name;
+        std::function<void()> work;
+        // Parallel-for tasks have these instead of work
+        std::function<size_t()> count;
+        std::function<void(size_t, size_t)> body;
+        size_t grain = 1;
+        TaskAffinity affinity = TaskAffinity::Worker;
+        uint32_t dependencyCount = 0;
+        std::vector<TaskId> successors;
+
+        std::atomic<uint32_t> pending{ 0 };
+        std::atomic<size_t> chunksLeft{ 0 };
+        double startMs = 0.0;
+        double endMs = 0.0;
+    };
+
+    BS::thread_pool<>* threadPool;
+    // A deque so tasks, which hold atomics, never move
+    std::deque<Task> tasks;
+    std::chrono::high_resolution_clock::time_point runStart{};
+    double runMs = 0.0;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<TaskId> mainQueue;
+    size_t remaining = 0;
+    std::exception_ptr error;
+
+    [[nodiscard]] double now() const;
+    void schedule(TaskId task);
+    void runOnWorker(TaskId task);
+    // Returns a successor for the calling worker to run next, or UINT32_MAX
+    TaskId execute(TaskId task);
+    void runChunk(TaskId task, size_t begin, size_t end);
+    TaskId finish(TaskId task);
+    void fail();
+};
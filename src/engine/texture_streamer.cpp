@@ -0,0 +1,117 @@
+#include <texture_streamer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+uint32_t getTextureLevelForSize(uint32_t textureSize, float screenSize, uint32_t levelCount)
+{
+    if (levelCount == 0)
+        return 0;
+    if (!(screenSize > 0.0f))
+        return levelCount - 1;
+    float level = std::floor(std::log2(static_cast<float>(textureSize) / screenSize));
+    return static_cast<uint32_t>(std::clamp(level, 0.0f, static_cast<float>(levelCount - 1)));
+}
+
+uint32_t TextureStreamer::addTexture(std::span<const uint64_t> levelSizes, uint32_t width, uint32_t height)
+{
+    Entry entry{};
+    entry.levelSizes.assign(levelSizes.begin(), levelSizes.end());
+    uint32_t levelCount = static_cast<uint32_t>(levelSizes.size());
+    while (entry.tailLevel + 1 < levelCount &&
+           std::max(width >> entry.tailLevel, height >> entry.tailLevel) > TEXTURE_TAIL_SIZE)
+        ++entry.tailLevel;
+    entry.residentLevel = entry.tailLevel;
+    entry.wantedLevel = entry.tailLevel;
+
+    // The tail can't be evicted, so it is counted even when it goes over the budget
+    residentBytes += getBytes(entry, entry.tailLevel);
+    entries.push_back(std::move(entry));
+    return entries.back().tailLevel;
+}
+
+void TextureStreamer::request(uint32_t texture, uint32_t level, uint64_t frame)
+{
+    Entry& entry = entries[texture];
+    level = std::min(level, entry.tailLevel);
+    if (entry.lastUsed != frame) {
+        entry.lastUsed = frame;
+        entry.wantedLevel = level;
+    } else {
+        entry.wantedLevel = std::min(entry.wantedLevel, level);
+    }
+}
+
+std::vector<ResidencyChange> TextureStreamer::update(uint64_t frame, size_t maxChanges)
+{
+    std::vector<ResidencyChange> changes;
+
+    // Textures that aren't needed this frame give their mips back to the tail, least recently used first
+    std::vector<uint32_t> victims;
+    for (uint32_t i = 0; i < entries.size(); ++i) {
+        const Entry& entry = entries[i];
+        if (!entry.pending && entry.lastUsed != frame && entry.residentLevel < entry.tailLevel)
+            victims.push_back(i);
+    }
+    std::ranges::sort(victims, {}, [&](uint32_t i) { return entries[i].lastUsed; });
+    size_t nextVictim = 0;
+    auto makeRoom = [&](uint64_t bytes) {
+        while (budget != 0 && residentBytes + bytes > budget && nextVictim < victims.size() &&
+               changes.size() < maxChanges) {
+            uint32_t victim = victims[nextVictim++];
+            setResidentLevel(victim, entries[victim].tailLevel, changes);
+        }
+    };
+    // Only needed after the budget was lowered, otherwise loads never go over it
+    makeRoom(0);
+
+    // Textures in view that want finer mips, the ones furthest from what they want first
+    std::vector<uint32_t> loads;
+    for (uint32_t i = 0; i < entries.size(); ++i) {
+        const Entry& entry = entries[i];
+        if (!entry.pending && entry.lastUsed == frame && entry.wantedLevel < entry.residentLevel)
+            loads.push_back(i);
+    }
+    std::ranges::sort(loads, std::ranges::greater{},
+                      [&](uint32_t i) { return entries[i].residentLevel - entries[i].wantedLevel; });
+
+    for (uint32_t texture : loads) {
+        if (changes.size() >= maxChanges)
+            break;
+        Entry& entry = entries[texture];
+        uint64_t resident = getBytes(entry, entry.residentLevel);
+        uint32_t level = entry.wantedLevel;
+        makeRoom(getBytes(entry, level) - resident);
+        // Whatever still doesn't fit is loaded as far as it does
+        while (budget != 0 && level < entry.residentLevel && residentBytes + getBytes(entry, level) - resident > budget)
+            ++level;
+        if (level < entry.residentLevel && changes.size() < maxChanges)
+            setResidentLevel(texture, level, changes);
+    }
+    return changes;
+}
+
+void TextureStreamer::commit(uint32_t texture)
+{
+    Entry& entry = entries[texture];
+    if (entry.pending) {
+        entry.pending = false;
+        pendingCount--;
+    }
+}
+
+uint64_t TextureStreamer::getBytes(const Entry& entry, uint32_t level)
+{
+    return std::accumulate(entry.levelSizes.begin() + level, entry.levelSizes.end(), uint64_t{ 0 });
+}
+
+void TextureStreamer::setResidentLevel(uint32_t texture, uint32_t level, std::vector<ResidencyChange>& changes)
+{
+    Entry& entry = entries[texture];
+    residentBytes = residentBytes - getBytes(entry, entry.residentLevel) + getBytes(entry, level);
+    entry.residentLevel = level;
+    entry.pending = true;
+    pendingCount++;
+    changes.push_back(ResidencyChange{ texture, level });
+}
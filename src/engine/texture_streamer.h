@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Mips at or below this size in both dimensions form a texture's tail, which is resident for as long as the texture
+constexpr uint32_t TEXTURE_TAIL_SIZE = 128;
+
+// The resident mips of a texture becoming [level, levelCount)
+struct ResidencyChange {
+    uint32_t texture;
+    uint32_t level;
+};
+
+// Mip level whose texels come closest to one per pixel for a texture covering screenSize pixels
+uint32_t getTextureLevelForSize(uint32_t textureSize, float screenSize, uint32_t levelCount);
+
+// Decides which mips of each texture are resident. A texture starts with only its tail; finer levels are requested
+// every frame for the textures in view and loaded while they fit the budget, taking mips back from the least recently
+// used textures when they don't. This only keeps the books: the caller makes each change and calls commit() once it
+// has landed, and until then the texture is left alone. Resident bytes are counted at the target levels.
+class TextureStreamer
+{
+  public:
+    // A budget of 0 is unlimited
+    explicit TextureStreamer(uint64_t budget = 0) : budget(budget) {}
+
+    // levelSizes holds the bytes of every mip level, level 0 first. Returns the tail level the texture starts at.
+    uint32_t addTexture(std::span<const uint64_t> levelSizes, uint32_t width, uint32_t height);
+    // The finest level the texture is needed at this frame, the finest of a frame's requests wins. frame starts at 1.
+    void request(uint32_t texture, uint32_t level, uint64_t frame);
+    // Picks up to maxChanges residency changes to make this frame
+    std::vector<ResidencyChange> update(uint64_t frame, size_t maxChanges);
+    void commit(uint32_t texture);
+
+    void setBudget(uint64_t bytes) { budget = bytes; }
+    [[nodiscard]] uint64_t getBudget() const { return budget; }
+    [[nodiscard]] uint64_t getResidentBytes() const { return residentBytes; }
+    [[nodiscard]] size_t getPendingCount() const { return pendingCount; }
+    [[nodiscard]] uint32_t getResidentLevel(uint32_t texture) const { return entries[texture].residentLevel; }
+    [[nodiscard]] uint32_t getWantedLevel(uint32_t texture) const { return entries[texture].wantedLevel; }
+
+  private:
+    struct Entry {
+        std::vector<uint64_t> levelSizes;
+        uint32_t tailLevel = 0;
+        uint32_t residentLevel = 0;
+        uint32_t wantedLevel = 0;
+        uint64_t lastUsed = 0;
+        bool pending = false;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t budget = 0;
+    uint64_t residentBytes = 0;
+    size_t pendingCount = 0;
+
+    // Bytes of levels [level, levelCount)
+    static uint64_t getBytes(const Entry& entry, uint32_t level);
+    void setResidentLevel(uint32_t texture, uint32_t level, std::vector<ResidencyChange>& changes);
+};
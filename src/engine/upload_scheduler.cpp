@@ -0,0 +1,255 @@
+#include <upload_scheduler.h>
+
+#include <cstring>
+
+UploadScheduler::UploadScheduler(const vk::raii::Device& device, const vk::raii::Queue& queue,
+                                 uint32_t queueFamilyIndex, VmaAllocator allocator, vk::DeviceSize ringSize)
+    : device(&device), queue(&queue), allocator(allocator), ringSize(ringSize)
+{
+    vk::CommandPoolCreateInfo poolInfo{};
+    poolInfo
+        .setFlags(vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer)
+        .setQueueFamilyIndex(queueFamilyIndex);
+    commandPool = vk::raii::CommandPool(device, poolInfo);
+
+    vk::SemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.setSemaphoreType(vk::SemaphoreType::eTimeline).setInitialValue(0);
+    vk::SemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.setPNext(&typeInfo);
+    timeline = vk::raii::Semaphore(device, semaphoreInfo);
+
+    vk::BufferCreateInfo ringInfo{};
+    ringInfo.setSize(ringSize)
+        .setUsage(vk::BufferUsageFlagBits::eTransferSrc)
+        .setSharingMode(vk::SharingMode::eExclusive);
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_AUTO;
+    allocInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    ring = GpuBuffer(allocator, ringInfo, allocInfo);
+}
+
+UploadHandle UploadScheduler::uploadBuffer(const void* data, vk::DeviceSize size, vk::Buffer dstBuffer,
+                                           vk::DeviceSize dstOffset)
+{
+    if (size == 0)
+        return submittedValue;
+
+    vk::Buffer srcBuffer = nullptr;
+    vk::DeviceSize srcOffset = stage(data, size, srcBuffer);
+
+    Batch& batch = currentBatch();
+    batch.commandBuffer.copyBuffer(srcBuffer, dstBuffer, vk::BufferCopy(srcOffset, dstOffset, size));
+    bufferCopiesPending = true;
+    pendingCount++;
+    return batch.value;
+}
+
+UploadHandle UploadScheduler::uploadImage(const void* data, vk::DeviceSize size, vk::Image image, uint32_t mipLevels,
+                                          std::span<const vk::BufferImageCopy> regions)
+{
+    vk::Buffer srcBuffer = nullptr;
+    vk::DeviceSize srcOffset = stage(data, size, srcBuffer);
+
+    Batch& batch = currentBatch();
+
+    vk::ImageSubresourceRange range{};
+    range.setAspectMask(vk::ImageAspectFlagBits::eColor).setBaseMipLevel(0).setLevelCount(mipLevels).setLayerCount(1);
+
+    vk::ImageMemoryBarrier2 toTransfer{};
+    toTransfer.setSrcStageMask(vk::PipelineStageFlagBits2::eNone)
+        .setSrcAccessMask({})
+        .setDstStageMask(vk::PipelineStageFlagBits2::eCopy)
+        .setDstAccessMask(vk::AccessFlagBits2::eTransferWrite)
+        .setOldLayout(vk::ImageLayout::eUndefined)
+        .setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+        .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setImage(image)
+        .setSubresourceRange(range);
+    vk::DependencyInfo toTransferInfo{};
+    toTransferInfo.setImageMemoryBarrierCount(1).setPImageMemoryBarriers(&toTransfer);
+    batch.commandBuffer.pipelineBarrier2(toTransferInfo);
+
+    std::vector<vk::BufferImageCopy> copies(regions.begin(), regions.end());
+    for (auto& copy : copies)
+        copy.bufferOffset += srcOffset;
+    batch.commandBuffer.copyBufferToImage(srcBuffer, image, vk::ImageLayout::eTransferDstOptimal, copies);
+
+    vk::ImageMemoryBarrier2 toShader = toTransfer;
+    toShader.setSrcStageMask(vk::PipelineStageFlagBits2::eCopy)
+        .setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite)
+        .setDstStageMask(vk::PipelineStageFlagBits2::eFragmentShader)
+        .setDstAccessMask(vk::AccessFlagBits2::eShaderSampledRead)
+        .setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+        .setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+    vk::DependencyInfo toShaderInfo{};
+    toShaderInfo.setImageMemoryBarrierCount(1).setPImageMemoryBarriers(&toShader);
+    batch.commandBuffer.pipelineBarrier2(toShaderInfo);
+
+    pendingCount++;
+    return batch.value;
+}
+
+UploadHandle UploadScheduler::flush()
+{
+    retire();
+    if (!recording.has_value())
+        return submittedValue;
+
+    Batch batch = std::move(recording.value());
+    recording.reset();
+
+    if (bufferCopiesPending) {
+        // One barrier makes every buffer copy in the batch visible to whatever reads it next
+        vk::MemoryBarrier2 barrier{};
+        barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eCopy)
+            .setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite)
+            .setDstStageMask(vk::PipelineStageFlagBits2::eVertexAttributeInput |
+                             vk::PipelineStageFlagBits2::eIndexInput | vk::PipelineStageFlagBits2::eDrawIndirect |
+                             vk::PipelineStageFlagBits2::eAllGraphics | vk::PipelineStageFlagBits2::eComputeShader |
+                             vk::PipelineStageFlagBits2::eCopy)
+            .setDstAccessMask(vk::AccessFlagBits2::eVertexAttributeRead | vk::AccessFlagBits2::eIndexRead |
+                              vk::AccessFlagBits2::eIndirectCommandRead | vk::AccessFlagBits2::eShaderRead |
+                              vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite);
+        vk::DependencyInfo dependencyInfo{};
+        dependencyInfo.setMemoryBarrierCount(1).setPMemoryBarriers(&barrier);
+        batch.commandBuffer.pipelineBarrier2(dependencyInfo);
+    }
+    batch.commandBuffer.end();
+
+    vk::CommandBufferSubmitInfo commandBufferInfo{};
+    commandBufferInfo.setCommandBuffer(*batch.commandBuffer);
+    vk::SemaphoreSubmitInfo signalInfo{};
+    signalInfo.setSemaphore(*timeline).setValue(batch.value).setStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+    vk::SubmitInfo2 submitInfo{};
+    submitInfo.setCommandBufferInfoCount(1)
+        .setPCommandBufferInfos(&commandBufferInfo)
+        .setSignalSemaphoreInfoCount(1)
+        .setPSignalSemaphoreInfos(&signalInfo);
+    queue->submit2(submitInfo);
+
+    submittedValue = batch.value;
+    inFlight.push_back(std::move(batch));
+    bufferCopiesPending = false;
+    pendingCount = 0;
+    return submittedValue;
+}
+
+bool UploadScheduler::isComplete(UploadHandle handle) const
+{
+    return handle <= submittedValue && timeline.getCounterValue() >= handle;
+}
+
+void UploadScheduler::wait(UploadHandle handle)
+{
+    if (handle > submittedValue)
+        flush();
+
+    vk::SemaphoreWaitInfo waitInfo{};
+    waitInfo.setSemaphoreCount(1).setPSemaphores(&*timeline).setPValues(&handle);
+    while (vk::Result::eTimeout == device->waitSemaphores(waitInfo, UINT64_MAX))
+        ;
+    retire();
+}
+
+UploadScheduler::Batch& UploadScheduler::currentBatch()
+{
+    if (!recording.has_value()) {
+        vk::raii::CommandBuffer commandBuffer = nullptr;
+        if (!freeCommandBuffers.empty()) {
+            commandBuffer = std::move(freeCommandBuffers.back());
+            freeCommandBuffers.pop_back();
+        } else {
+            vk::CommandBufferAllocateInfo allocInfo{};
+            allocInfo.setCommandPool(*commandPool)
+                .setLevel(vk::CommandBufferLevel::ePrimary)
+                .setCommandBufferCount(1);
+            commandBuffer = std::move(vk::raii::CommandBuffers(*device, allocInfo).front());
+        }
+
+        vk::CommandBufferBeginInfo beginInfo{};
+        beginInfo.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+        commandBuffer.begin(beginInfo);
+        recording = Batch{ std::move(commandBuffer), submittedValue + 1, {} };
+    }
+    return recording.value();
+}
+
+vk::DeviceSize UploadScheduler::stage(const void* data, vk::DeviceSize size, vk::Buffer& srcBuffer)
+{
+    if (size > ringSize) {
+        // Too big for the ring, give it its own staging buffer that lives as long as the batch
+        vk::BufferCreateInfo bufferInfo{};
+        bufferInfo.setSize(size)
+            .setUsage(vk::BufferUsageFlagBits::eTransferSrc)
+            .setSharingMode(vk::SharingMode::eExclusive);
+        VmaAllocationCreateInfo allocInfo{};
+        allocInfo.usage = VMA_MEMORY_USAGE_AUTO;
+        allocInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        GpuBuffer staging(allocator, bufferInfo, allocInfo);
+        memcpy(staging.getMapped(), data, size);
+        staging.flush();
+
+        srcBuffer = *staging;
+        currentBatch().oversizedStaging.push_back(std::move(staging));
+        return 0;
+    }
+
+    vk::DeviceSize offset = 0;
+    while (!tryAllocate(size, offset)) {
+        // The ring is full of copies that haven't executed yet: submit ours if they're in the way and wait for
+        // the oldest batch to free its space
+        if (regions.front().value > submittedValue)
+            flush();
+        wait(regions.front().value);
+    }
+    regions.push_back(RingRegion{ offset, offset + size, submittedValue + 1 });
+
+    memcpy(static_cast<uint8_t*>(ring.getMapped()) + offset, data, size);
+    ring.flush(offset, size);
+    srcBuffer = *ring;
+    return offset;
+}
+
+bool UploadScheduler::tryAllocate(vk::DeviceSize size, vk::DeviceSize& offset)
+{
+    if (regions.empty()) {
+        // Nothing in flight, start over at the beginning of the ring
+        offset = 0;
+        head = size;
+        return true;
+    }
+
+    vk::DeviceSize tail = regions.front().begin;
+    vk::DeviceSize aligned = (head + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+    if (head > tail) {
+        // Free space is [head, ringSize) followed by [0, tail)
+        if (aligned + size <= ringSize) {
+            offset = aligned;
+        } else if (size <= tail) {
+            offset = 0;
+        } else {
+            return false;
+        }
+    } else if (head < tail && aligned + size <= tail) {
+        offset = aligned;
+    } else {
+        // head == tail with regions outstanding means the ring is full
+        return false;
+    }
+    head = offset + size;
+    return true;
+}
+
+void UploadScheduler::retire()
+{
+    uint64_t completed = timeline.getCounterValue();
+    while (!regions.empty() && regions.front().value <= completed)
+        regions.pop_front();
+    while (!inFlight.empty() && inFlight.front().value <= completed) {
+        auto& batch = inFlight.front();
+        batch.commandBuffer.reset();
+        freeCommandBuffers.push_back(std::move(batch.commandBuffer));
+        inFlight.pop_front();
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <gpu_memory.h>
+
+// Identifies the batch an upload was recorded into. It is complete once the scheduler's timeline semaphore reaches it.
+using UploadHandle = uint64_t;
+
+// Stages uploads through a persistently mapped ring buffer and records their copies and layout barriers into one
+// command buffer per batch. flush() submits the batch without waiting; completion is tracked with a timeline
+// semaphore. Work submitted to the same queue afterwards is ordered after the batch, so frames can use the
+// destination resources as soon as the batch has been flushed.
+class UploadScheduler
+{
+  public:
+    UploadScheduler(std::nullptr_t) {}
+    UploadScheduler(const vk::raii::Device& device, const vk::raii::Queue& queue, uint32_t queueFamilyIndex,
+                    VmaAllocator allocator, vk::DeviceSize ringSize);
+
+    UploadHandle uploadBuffer(const void* data, vk::DeviceSize size, vk::Buffer dstBuffer,
+                              vk::DeviceSize dstOffset = 0);
+    // Region buffer offsets are relative to data. The image ends up in SHADER_READ_ONLY_OPTIMAL.
+    UploadHandle uploadImage(const void* data, vk::DeviceSize size, vk::Image image, uint32_t mipLevels,
+                             std::span<const vk::BufferImageCopy> regions);
+
+    // Submits the batch being recorded, if any, and returns its handle.
+    UploadHandle flush();
+    [[nodiscard]] bool isComplete(UploadHandle handle) const;
+    void wait(UploadHandle handle);
+    [[nodiscard]] size_t getPendingCount() const { return pendingCount; }
+
+  private:
+    struct RingRegion {
+        vk::DeviceSize begin;
+        vk::DeviceSize end;
+        uint64_t value;
+    };
+
+    struct Batch {
+        vk::raii::CommandBuffer commandBuffer;
+        uint64_t value;
+        std::vector<GpuBuffer> oversizedStaging;
+    };
+
+    static constexpr vk::DeviceSize STAGING_ALIGNMENT = 16;
+
+    const vk::raii::Device* device = nullptr;
+    const vk::raii::Queue* queue = nullptr;
+    VmaAllocator allocator = VK_NULL_HANDLE;
+    vk::raii::CommandPool commandPool = nullptr;
+    vk::raii::Semaphore timeline = nullptr;
+
+    GpuBuffer ring = nullptr;
+    vk::DeviceSize ringSize = 0;
+    vk::DeviceSize head = 0;
+    std::deque<RingRegion> regions;
+
+    std::optional<Batch> recording;
+    std::deque<Batch> inFlight;
+    std::vector<vk::raii::CommandBuffer> freeCommandBuffers;
+    uint64_t submittedValue = 0;
+    bool bufferCopiesPending = false;
+    size_t pendingCount = 0;
+
+    Batch& currentBatch();
+    vk::DeviceSize stage(const void* data, vk::DeviceSize size, vk::Buffer& srcBuffer);
+    bool tryAllocate(vk::DeviceSize size, vk::DeviceSize& offset);
+    void retire();
+};